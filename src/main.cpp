@@ -4,18 +4,67 @@
  * The Oberon-07 programming language is described in
  * https://people.inf.ethz.ch/wirth/Oberon/Oberon07.Report.pdf
  */
+#include <cstddef>
+#include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 
 // Details about the IWYU pragma below can be found at
 // https://clangd.llvm.org/guides/include-cleaner#unused-include-warning
 #include "CLI/CLI.hpp" // IWYU pragma: keep
 
+import obc.alloc_stats;
 import obc.error_info;
 import obc.parser;
 import obc.scanner;
+import obc.trace;
 import obc.version;
 
+namespace {
+
+    void reportScanResults(const std::string &srcFile, const std::vector<obc::Token> &tokens,
+                           const std::vector<obc::ErrorInfo> &errors) {
+        // Report on tokens.
+        if (tokens.empty()) {
+            std::cout << "No token found in '" << srcFile << "'.\n";
+        } else {
+            std::cout << "Scanned " << tokens.size()
+                      << (tokens.size() == 1U ? " token" : " tokens") << " from " << srcFile
+                      << ":\n";
+            for (const auto &token : tokens) {
+                std::cout << token << "\n";
+            }
+        }
+        // Report on errors.
+        if (!errors.empty()) {
+            if (errors.size() == 1) {
+                std::cout << "An error happened while scanning '" << srcFile << "':\n";
+            } else {
+                std::cout << errors.size() << " errors happened while scanning '" << srcFile
+                          << "':\n";
+            }
+            for (const auto &error : errors) {
+                if (error.line < 0) {
+                    // Source file errors aren't located - their messages name the file instead.
+                    error.writeMsg(std::cout, srcFile);
+                    std::cout << "\n";
+                } else {
+                    std::cout << error << "\n";
+                }
+            }
+        }
+    }
+
+    void reportAllocStats(const std::string &phase, const obc::AllocStats &stats) {
+        std::cerr << "Heap usage of " << phase << ": " << stats.allocations
+                  << " allocations, " << stats.allocatedBytes << " bytes allocated, "
+                  << stats.peakLiveBytes << " bytes at peak.\n";
+    }
+
+} // namespace
+
 // NOLINTBEGIN(bugprone-exception-escape)
 int main(const int argc, char **argv) {
     CLI::App app{"An Oberon-07 to LLVM-IR compiler"};
@@ -27,9 +76,29 @@ int main(const int argc, char **argv) {
                  "Must keywords be all lowercase? (in the Oberon-07 spec, keywords are all "
                  "uppercase)");
 
+    bool pipelined{false};
+    app.add_flag("--pipelined", pipelined,
+                 "Scan and parse concurrently, with the scanner running on a separate thread");
+
+    bool allocStats{false};
+    app.add_flag("--alloc-stats", allocStats,
+                 "Report the heap usage of each compilation phase (only available in builds "
+                 "configured with OBC_ALLOC_STATS)");
+
+    std::size_t maxErrors{obc::NO_ERRORS_LIMIT};
+    app.add_option("--max-errors", maxErrors,
+                   "Maximum number of errors to be found before compilation stops (0 for no "
+                   "limit)");
+
+    std::string traceFile;
+    app.add_option("--trace", traceFile,
+                   "Write the begin and end of each compilation phase, per module and thread, "
+                   "to a file in the Chrome trace-event JSON format");
+
     std::string srcFile;
     CLI::Option *srcFileOption =
-          app.add_option("src_file", srcFile, "Oberon-07 source file to be compiled");
+          app.add_option("src_file", srcFile,
+                         "Oberon-07 source file to be compiled ('-' for the standard input)");
     srcFileOption->required();
 
     try {
@@ -38,32 +107,71 @@ int main(const int argc, char **argv) {
         return app.exit(e);
     }
 
+    // A source read from the standard input is scanned as it arrives, through a fixed-size
+    // window, instead of being loaded into memory first.
+    const bool fromStdin = srcFile == "-";
+    const std::string srcName = fromStdin ? std::string{"<stdin>"} : srcFile;
+    if (fromStdin) {
+        std::ios::sync_with_stdio(false);
+    }
+
+    if (allocStats && !obc::globalAllocHooksActive()) {
+        std::cerr << "Heap usage is not available: obc has been built without "
+                     "OBC_ALLOC_STATS.\n";
+        allocStats = false;
+    }
+
+    if (!traceFile.empty()) {
+        obc::setTracingEnabled(true);
+    }
+
     // For now, we just scan and printout the results.
-    auto [tokens, errors] = obc::Scanner::scanSrcFile(srcFile, lowerCaseKeywords);
-    // Report on tokens.
-    if (tokens.empty()) {
-        std::cout << "No token found in '" << srcFile << "'.\n";
+    if (pipelined) {
+        const obc::AllocPhase scanParsePhase;
+        obc::TokenQueue tokenQueue;
+        std::vector<obc::ErrorInfo> errors;
+        std::thread scanThread{[&] {
+            const obc::TraceModule traceModule{srcName};
+            errors = fromStdin ? obc::Scanner::scanStream(std::cin, tokenQueue,
+                                                          lowerCaseKeywords, maxErrors)
+                                       .errors
+                               : obc::Scanner::scanSrcFile(srcFile, tokenQueue,
+                                                           lowerCaseKeywords, maxErrors)
+                                       .errors;
+        }};
+        const obc::TraceModule traceModule{srcName};
+        const obc::Parser parser{tokenQueue};
+        scanThread.join();
+        // Both phases run concurrently - their heap usage can only be measured as a whole.
+        const obc::AllocStats scanParseStats = scanParsePhase.stats();
+        reportScanResults(srcName, parser.tokens(), errors);
+        if (allocStats) {
+            reportAllocStats("scan + parse", scanParseStats);
+        }
     } else {
-        std::cout << "Scanned " << tokens.size()
-                  << (tokens.size() == 1U ? " token" : " tokens") << " from " << srcFile
-                  << ":\n";
-        for (const auto &token : tokens) {
-            std::cout << token << "\n";
+        const obc::TraceModule traceModule{srcName};
+        const obc::AllocPhase scanPhase;
+        auto [tokens, errors] =
+              fromStdin ? obc::Scanner::scanStream(std::cin, lowerCaseKeywords, maxErrors)
+                        : obc::Scanner::scanSrcFile(srcFile, lowerCaseKeywords, maxErrors);
+        const obc::AllocStats scanStats = scanPhase.stats();
+        reportScanResults(srcName, tokens, errors);
+        const obc::AllocPhase parsePhase;
+        obc::Parser parser{std::move(tokens)};
+        const obc::AllocStats parseStats = parsePhase.stats();
+        if (allocStats) {
+            reportAllocStats("scan", scanStats);
+            reportAllocStats("parse", parseStats);
         }
     }
-    // Report on errors.
-    if (!errors.empty()) {
-        if (errors.size() == 1) {
-            std::cout << "An error happened while scanning '" << srcFile << "':\n";
-        } else {
-            std::cout << errors.size() << " errors happened while scanning '" << srcFile
-                      << "':\n";
-        }
-        for (const auto &error : errors) {
-            std::cout << error << "\n";
+
+    if (!traceFile.empty()) {
+        // All the traced threads have already been joined.
+        std::ofstream traceStream(traceFile);
+        obc::writeChromeTrace(traceStream);
+        if (!traceStream) {
+            std::cerr << "Failed to write the trace to '" << traceFile << "'.\n";
         }
     }
-
-    obc::Parser parser{std::move(tokens)};
 }
 // NOLINTEND(bugprone-exception-escape)
@@ -0,0 +1,172 @@
+/**
+ * Replacements for the global operator new/delete that count the heap allocations of the
+ * program they are linked into. The counts are made available through the obc.alloc_stats
+ * module.
+ *
+ * Every block is preceded by a header that stores the size requested for it, so the
+ * deallocations can be accounted for even when the unsized operator delete is called.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+import obc.alloc_stats;
+
+namespace {
+
+    // Size of the header in front of blocks with the default alignment.
+    constexpr std::size_t HEADER_SIZE{alignof(std::max_align_t)};
+
+    void *allocBlock(const std::size_t size, const std::size_t alignment) noexcept {
+        // The header takes a whole alignment unit, so the block keeps its alignment.
+        const std::size_t headerSize = std::max(HEADER_SIZE, alignment);
+        const std::size_t blockSize = headerSize + std::max<std::size_t>(size, 1U);
+        void *rawPtr = nullptr;
+        if (alignment <= HEADER_SIZE) {
+            rawPtr = std::malloc(blockSize); // NOLINT(*-no-malloc, *-owning-memory)
+        } else {
+#if defined(_MSC_VER)
+            // The Microsoft supplied runtime doesn't provide std::aligned_alloc.
+            rawPtr = _aligned_malloc(blockSize, alignment);
+#else
+            // std::aligned_alloc requires the size to be a multiple of the alignment.
+            rawPtr = std::aligned_alloc(alignment,
+                                        (blockSize + alignment - 1) / alignment * alignment);
+#endif
+        }
+        if (rawPtr == nullptr) {
+            return nullptr;
+        }
+        auto *bytePtr = static_cast<std::byte *>(rawPtr);
+        *static_cast<std::size_t *>(rawPtr) = size;
+        obc::recordGlobalAlloc(size);
+        return bytePtr + headerSize; // NOLINT(*-pointer-arithmetic)
+    }
+
+    void freeBlock(void *ptr, const std::size_t alignment) noexcept {
+        if (ptr == nullptr) {
+            return;
+        }
+        const std::size_t headerSize = std::max(HEADER_SIZE, alignment);
+        // NOLINTNEXTLINE(*-pointer-arithmetic)
+        void *rawPtr = static_cast<std::byte *>(ptr) - headerSize;
+        obc::recordGlobalDealloc(*static_cast<std::size_t *>(rawPtr));
+        if (alignment <= HEADER_SIZE) {
+            std::free(rawPtr); // NOLINT(*-no-malloc, *-owning-memory)
+        } else {
+#if defined(_MSC_VER)
+            _aligned_free(rawPtr);
+#else
+            std::free(rawPtr); // NOLINT(*-no-malloc, *-owning-memory)
+#endif
+        }
+    }
+
+    void *allocOrThrow(const std::size_t size, const std::size_t alignment) {
+        while (true) {
+            if (void *ptr = allocBlock(size, alignment); ptr != nullptr) {
+                return ptr;
+            }
+            // Gives the new handler (if any) a chance to release some memory.
+            std::new_handler handler = std::get_new_handler();
+            if (handler == nullptr) {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    std::size_t alignmentOf(const std::align_val_t alignment) {
+        return static_cast<std::size_t>(alignment);
+    }
+
+} // namespace
+
+// NOLINTBEGIN(*-new-delete-overloads)
+void *operator new(const std::size_t size) {
+    return allocOrThrow(size, HEADER_SIZE);
+}
+
+void *operator new[](const std::size_t size) {
+    return allocOrThrow(size, HEADER_SIZE);
+}
+
+void *operator new(const std::size_t size, const std::align_val_t alignment) {
+    return allocOrThrow(size, alignmentOf(alignment));
+}
+
+void *operator new[](const std::size_t size, const std::align_val_t alignment) {
+    return allocOrThrow(size, alignmentOf(alignment));
+}
+
+void *operator new(const std::size_t size, const std::nothrow_t & /*unused*/) noexcept {
+    return allocBlock(size, HEADER_SIZE);
+}
+
+void *operator new[](const std::size_t size, const std::nothrow_t & /*unused*/) noexcept {
+    return allocBlock(size, HEADER_SIZE);
+}
+
+void *operator new(const std::size_t size, const std::align_val_t alignment,
+                   const std::nothrow_t & /*unused*/) noexcept {
+    return allocBlock(size, alignmentOf(alignment));
+}
+
+void *operator new[](const std::size_t size, const std::align_val_t alignment,
+                     const std::nothrow_t & /*unused*/) noexcept {
+    return allocBlock(size, alignmentOf(alignment));
+}
+
+void operator delete(void *ptr) noexcept {
+    freeBlock(ptr, HEADER_SIZE);
+}
+
+void operator delete[](void *ptr) noexcept {
+    freeBlock(ptr, HEADER_SIZE);
+}
+
+void operator delete(void *ptr, const std::size_t /*size*/) noexcept {
+    freeBlock(ptr, HEADER_SIZE);
+}
+
+void operator delete[](void *ptr, const std::size_t /*size*/) noexcept {
+    freeBlock(ptr, HEADER_SIZE);
+}
+
+void operator delete(void *ptr, const std::align_val_t alignment) noexcept {
+    freeBlock(ptr, alignmentOf(alignment));
+}
+
+void operator delete[](void *ptr, const std::align_val_t alignment) noexcept {
+    freeBlock(ptr, alignmentOf(alignment));
+}
+
+void operator delete(void *ptr, const std::size_t /*size*/,
+                     const std::align_val_t alignment) noexcept {
+    freeBlock(ptr, alignmentOf(alignment));
+}
+
+void operator delete[](void *ptr, const std::size_t /*size*/,
+                       const std::align_val_t alignment) noexcept {
+    freeBlock(ptr, alignmentOf(alignment));
+}
+
+void operator delete(void *ptr, const std::nothrow_t & /*unused*/) noexcept {
+    freeBlock(ptr, HEADER_SIZE);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t & /*unused*/) noexcept {
+    freeBlock(ptr, HEADER_SIZE);
+}
+
+void operator delete(void *ptr, const std::align_val_t alignment,
+                     const std::nothrow_t & /*unused*/) noexcept {
+    freeBlock(ptr, alignmentOf(alignment));
+}
+
+void operator delete[](void *ptr, const std::align_val_t alignment,
+                       const std::nothrow_t & /*unused*/) noexcept {
+    freeBlock(ptr, alignmentOf(alignment));
+}
+// NOLINTEND(*-new-delete-overloads)
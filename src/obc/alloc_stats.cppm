@@ -0,0 +1,180 @@
+module;
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+
+export module obc.alloc_stats;
+
+namespace obc {
+
+    /**
+     * Heap allocation statistics - either totals since the start of the process or the
+     * share of a given phase of it (see AllocPhase).
+     */
+    export struct AllocStats {
+        std::size_t allocations{0};
+        std::size_t deallocations{0};
+        // Total number of bytes requested by the allocations.
+        std::size_t allocatedBytes{0};
+        // Number of bytes allocated and not yet deallocated.
+        std::size_t liveBytes{0};
+        // Highest number of live bytes.
+        std::size_t peakLiveBytes{0};
+    };
+
+    /**
+     * Thread-safe allocation counters. Kept apart from AllocStats, which is a plain snapshot
+     * of their values.
+     */
+    class AllocCounters {
+       public:
+        void recordAlloc(const std::size_t size) {
+            m_allocations.fetch_add(1, std::memory_order_relaxed);
+            m_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+            const std::size_t live =
+                  m_liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+            std::size_t peak = m_peakLiveBytes.load(std::memory_order_relaxed);
+            while (live > peak && !m_peakLiveBytes.compare_exchange_weak(
+                                        peak, live, std::memory_order_relaxed)) {
+            }
+        }
+
+        void recordDealloc(const std::size_t size) {
+            m_deallocations.fetch_add(1, std::memory_order_relaxed);
+            m_liveBytes.fetch_sub(size, std::memory_order_relaxed);
+        }
+
+        void resetPeak() {
+            m_peakLiveBytes.store(m_liveBytes.load(std::memory_order_relaxed),
+                                  std::memory_order_relaxed);
+        }
+
+        AllocStats snapshot() const {
+            return AllocStats{
+                  .allocations = m_allocations.load(std::memory_order_relaxed),
+                  .deallocations = m_deallocations.load(std::memory_order_relaxed),
+                  .allocatedBytes = m_allocatedBytes.load(std::memory_order_relaxed),
+                  .liveBytes = m_liveBytes.load(std::memory_order_relaxed),
+                  .peakLiveBytes = m_peakLiveBytes.load(std::memory_order_relaxed)};
+        }
+
+       private:
+        std::atomic<std::size_t> m_allocations{0};
+        std::atomic<std::size_t> m_deallocations{0};
+        std::atomic<std::size_t> m_allocatedBytes{0};
+        std::atomic<std::size_t> m_liveBytes{0};
+        std::atomic<std::size_t> m_peakLiveBytes{0};
+    };
+
+    // Counters of the global operator new/delete. Constant initialized, as allocations can
+    // happen before any dynamic initialization takes place.
+    constinit AllocCounters globalCounters{};
+    constinit std::atomic<bool> globalHooksActive{false};
+
+    /**
+     * @brief Records an allocation made through the global operator new.
+     *
+     * @attention Meant to be called only by the operator new/delete replacements (in
+     * alloc_hooks.cpp) linked into the programs that want their allocations counted.
+     */
+    export void recordGlobalAlloc(const std::size_t size) {
+        globalHooksActive.store(true, std::memory_order_relaxed);
+        globalCounters.recordAlloc(size);
+    }
+
+    /**
+     * @brief Records a deallocation made through the global operator delete.
+     *
+     * @attention Meant to be called only by the operator new/delete replacements (in
+     * alloc_hooks.cpp) linked into the programs that want their allocations counted.
+     */
+    export void recordGlobalDealloc(const std::size_t size) {
+        globalCounters.recordDealloc(size);
+    }
+
+    /**
+     * @brief Returns whether the global operator new/delete replacements are counting the
+     * allocations of the process.
+     */
+    export bool globalAllocHooksActive() {
+        return globalHooksActive.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the global allocation statistics since the start of the process.
+     *
+     * @note All the statistics are zero unless the global operator new/delete replacements
+     * are linked into the program.
+     */
+    export AllocStats globalAllocStats() {
+        return globalCounters.snapshot();
+    }
+
+    /**
+     * @brief Measures the heap allocations of a phase of the process - from the construction
+     * of the AllocPhase to a call to stats().
+     *
+     * @attention The peak of live bytes is tracked process-wide: phases must not overlap, be
+     * it by nesting or by running on different threads.
+     */
+    export class AllocPhase {
+       public:
+        AllocPhase() {
+            globalCounters.resetPeak();
+            m_start = globalCounters.snapshot();
+        }
+
+        /**
+         * @brief Returns the allocation statistics of the phase so far.
+         *
+         * The live bytes and their peak are relative to the live bytes at the start of the
+         * phase.
+         */
+        AllocStats stats() const {
+            const AllocStats now = globalCounters.snapshot();
+            return AllocStats{.allocations = now.allocations - m_start.allocations,
+                              .deallocations = now.deallocations - m_start.deallocations,
+                              .allocatedBytes = now.allocatedBytes - m_start.allocatedBytes,
+                              .liveBytes = now.liveBytes - m_start.liveBytes,
+                              .peakLiveBytes = now.peakLiveBytes - m_start.liveBytes};
+        }
+
+       private:
+        AllocStats m_start;
+    };
+
+    /**
+     * @brief A polymorphic memory resource that counts the allocations it forwards to an
+     * upstream resource.
+     */
+    export class CountingResource : public std::pmr::memory_resource {
+       public:
+        explicit CountingResource(
+              std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+            : m_upstream{upstream} {}
+
+        AllocStats stats() const { return m_counters.snapshot(); }
+
+       private:
+        void* do_allocate(const std::size_t bytes, const std::size_t alignment) override {
+            void* ptr = m_upstream->allocate(bytes, alignment);
+            m_counters.recordAlloc(bytes);
+            return ptr;
+        }
+
+        void do_deallocate(void* ptr, const std::size_t bytes,
+                           const std::size_t alignment) override {
+            m_upstream->deallocate(ptr, bytes, alignment);
+            m_counters.recordDealloc(bytes);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        std::pmr::memory_resource* m_upstream;
+        AllocCounters m_counters;
+    };
+
+} // namespace obc
@@ -1,29 +1,193 @@
 module;
 
+#include <array>
+#include <cstddef>
+// ReSharper disable once CppUnusedIncludeDirective
+#include <cstring>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <string_view>
 
 export module obc.error_info;
 
 namespace obc {
 
+    // Size of the buffer for storing an errno corresponding message.
+    constexpr size_t ERR_MSG_BUFF_SIZE = 256U;
+
+    export enum class ErrorCode : unsigned char {
+        // clang-format off
+
+        // Source file errors (non-locatable)
+        FILE_NOT_AVAILABLE, FILE_READ_FAILED, STREAM_READ_FAILED,
+
+        // Lexical errors
+        UNEXPECTED_CHAR, INVALID_ENCODING, UNFINISHED_COMMENT, UNTERMINATED_STRING,
+        INVALID_SINGLE_CHAR_STRING, UNTERMINATED_HEX_INTEGER, NON_DECIMAL_REAL,
+        INVALID_SCALE_FACTOR_SIGN, MISSING_SCALE_FACTOR_DIGITS,
+
+        // Errors limit reached - the operation that found the errors has been stopped
+        TOO_MANY_ERRORS,
+
+        // clang-format on
+    };
+
+    /**
+     * @brief Writes a character, given by its code point, to an output stream - encoded in
+     * UTF-8, if it isn't an ASCII character.
+     */
+    void writeUtf8(std::ostream& ostream, const int codePoint) {
+        constexpr int maxOneByte = 0x7F;
+        constexpr int maxTwoBytes = 0x7FF;
+        constexpr int maxThreeBytes = 0xFFFF;
+        const auto contByte = [codePoint](const int shift) {
+            return static_cast<char>(0x80 | ((codePoint >> shift) & 0x3F));
+        };
+        if (codePoint <= maxOneByte) {
+            // Negative values are bytes of a source whose encoding hasn't been checked.
+            ostream << static_cast<char>(codePoint);
+        } else if (codePoint <= maxTwoBytes) {
+            ostream << static_cast<char>(0xC0 | (codePoint >> 6)) << contByte(0);
+        } else if (codePoint <= maxThreeBytes) {
+            ostream << static_cast<char>(0xE0 | (codePoint >> 12)) << contByte(6)
+                    << contByte(0);
+        } else {
+            ostream << static_cast<char>(0xF0 | (codePoint >> 18)) << contByte(12)
+                    << contByte(6) << contByte(0);
+        }
+    }
+
+    /**
+     * A compact record of an error. The human-readable message of the error is only formatted
+     * when it is rendered - either by msg() or by the insertion operator.
+     */
     export struct ErrorInfo {
+        ErrorCode code;
         int line = -1;   // -1 flags for a non-locatable error
         int column = -1; // -1 flags for a non-locatable error
-        std::string msg;
+        // Argument whose meaning depends on the error code: the offending character (its code
+        // point, for a non-ASCII one) for UNEXPECTED_CHAR, the offending byte for
+        // INVALID_ENCODING, the errno value for FILE_READ_FAILED and STREAM_READ_FAILED and
+        // the errors limit (capped at the largest int) for TOO_MANY_ERRORS.
+        int arg = 0;
+        // Index, in the source input, of the first byte of the offending lexeme - or of the
+        // offending byte, for an error found in a single byte. For TOO_MANY_ERRORS, the index
+        // at which the scan has been stopped.
+        std::size_t offset = 0;
+
+        /**
+         * @brief Formats the human-readable message of the error.
+         *
+         * @param srcName the name (e.g., the path) of the source the error has been found in.
+         * Only source file errors mention it - records don't keep it, as the caller of a scan
+         * already knows which source it has scanned.
+         * @return the message of the error, without its location.
+         */
+        std::string msg(std::string_view srcName = {}) const;
+
+        /**
+         * @brief Writes the human-readable message of the error to an output stream.
+         *
+         * @param ostream the stream the message is written to.
+         * @param srcName the name of the source the error has been found in - see msg().
+         */
+        void writeMsg(std::ostream& ostream, std::string_view srcName = {}) const;
     };
 
+    // Errors are kept by the thousand - e.g., by a scan session - so they must stay small.
+    static_assert(sizeof(ErrorInfo) <= 24);
+
+    std::string ErrorInfo::msg(const std::string_view srcName) const {
+        std::ostringstream ostream;
+        writeMsg(ostream, srcName);
+        return ostream.str();
+    }
+
+    void ErrorInfo::writeMsg(std::ostream& ostream, const std::string_view srcName) const {
+        switch (code) {
+            case ErrorCode::FILE_NOT_AVAILABLE:
+                if (srcName.empty()) {
+                    ostream << "Source file not found or not available for reading.";
+                } else {
+                    ostream << "File '" << srcName
+                            << "' not found or not available for reading.";
+                }
+                break;
+            case ErrorCode::FILE_READ_FAILED:
+            case ErrorCode::STREAM_READ_FAILED: {
+                std::array<char, ERR_MSG_BUFF_SIZE> errBuf{};
+#if defined(__MSVCRT__) || defined(_MSC_VER)
+                // On Windows, using the Microsoft supplied runtime, the safe
+                // version of strerror is not strerror_r, but strerror_s.
+                strerror_s(errBuf.data(), errBuf.size(), arg);
+                const char* errMsg = errBuf.data();
+#elif defined(__GLIBC__) && defined(_GNU_SOURCE)
+                // The GNU version of strerror_r may return a static string instead of
+                // filling in the given buffer.
+                const char* errMsg = strerror_r(arg, errBuf.data(), errBuf.size());
+#else
+                strerror_r(arg, errBuf.data(), errBuf.size());
+                const char* errMsg = errBuf.data();
+#endif
+                if (code == ErrorCode::STREAM_READ_FAILED) {
+                    ostream << "Error while reading the source stream: " << errMsg;
+                } else if (srcName.empty()) {
+                    ostream << "Error while reading the source file: " << errMsg;
+                } else {
+                    ostream << "Error while reading '" << srcName << "': " << errMsg;
+                }
+                break;
+            }
+            case ErrorCode::UNEXPECTED_CHAR:
+                ostream << "Unexpected character, '";
+                writeUtf8(ostream, arg);
+                ostream << "' found.";
+                break;
+            case ErrorCode::INVALID_ENCODING:
+                ostream << "Invalid UTF-8 byte, 0x" << std::hex << std::uppercase << arg
+                        << std::dec << std::nouppercase << ", found.";
+                break;
+            case ErrorCode::UNFINISHED_COMMENT:
+                ostream << "Source module ends in an unfinished comment.";
+                break;
+            case ErrorCode::UNTERMINATED_STRING:
+                ostream << "Unterminated string - strings must be on a single line.";
+                break;
+            case ErrorCode::INVALID_SINGLE_CHAR_STRING:
+                ostream << "Single character strings must have values between 0 and FF.";
+                break;
+            case ErrorCode::UNTERMINATED_HEX_INTEGER:
+                ostream << "Hexadecimal number must be terminated with an 'H'.";
+                break;
+            case ErrorCode::NON_DECIMAL_REAL:
+                ostream << "Real numbers must use only digits between 0 and 9.";
+                break;
+            case ErrorCode::INVALID_SCALE_FACTOR_SIGN:
+                ostream << "Real number scale factor must start with an 'E' followed by either "
+                           "a '+' or '-' signal.";
+                break;
+            case ErrorCode::MISSING_SCALE_FACTOR_DIGITS:
+                ostream << "Scale factor of a real number must have at least one digit after "
+                           "the '+' or '-' signal.";
+                break;
+            case ErrorCode::TOO_MANY_ERRORS:
+                ostream << "Too many errors (limit is " << arg << "); scan stopped.";
+                break;
+        }
+    }
+
     export std::ostream& operator<<(std::ostream& ostream, const ErrorInfo& errInf) {
         if (errInf.line < 0 && errInf.column < 0) {
-            ostream << errInf.msg;
+            errInf.writeMsg(ostream);
         } else if (errInf.column < 0) {
-            ostream << "(lin " << errInf.line << "): " << errInf.msg;
+            ostream << "(lin " << errInf.line << "): ";
+            errInf.writeMsg(ostream);
         } else {
-            ostream << "(lin " << errInf.line << ", col " << errInf.column << "): " << errInf.msg;
+            ostream << "(lin " << errInf.line << ", col " << errInf.column << "): ";
+            errInf.writeMsg(ostream);
         }
         return ostream;
     }
 
 } // namespace obc
-
-
@@ -1,13 +1,26 @@
 module;
 
+#include <iterator>
 #include <vector>
 
 module obc.parser;
 
 import obc.scanner;
+import obc.trace;
 
 namespace obc {
 
-    Parser::Parser(std::vector<Token>&& tokens) : m_tokens(std::move(tokens)) {}
+    Parser::Parser(std::vector<Token>&& tokens) : m_tokens(std::move(tokens)) {
+        const TraceScope parseScope{"parse"};
+    }
+
+    Parser::Parser(TokenQueue& tokenQueue) {
+        const TraceScope parseScope{"parse"};
+        TokenBatch batch;
+        while (tokenQueue.pop(batch)) {
+            m_tokens.insert(m_tokens.end(), std::make_move_iterator(batch.begin()),
+                            std::make_move_iterator(batch.end()));
+        }
+    }
 
 } // namespace obc
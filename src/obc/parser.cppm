@@ -12,6 +12,17 @@ namespace obc {
        public:
         Parser(std::vector<Token> &&tokens);
 
+        /**
+         * @brief Creates a parser that consumes its tokens from a queue, as they are pushed by
+         * a scanner running on another thread.
+         *
+         * @param tokenQueue the queue the tokens are taken from - it must eventually be closed
+         * by its producer.
+         */
+        Parser(TokenQueue &tokenQueue);
+
+        const std::vector<Token> &tokens() const { return m_tokens; }
+
        private:
         std::vector<Token> m_tokens;
     };
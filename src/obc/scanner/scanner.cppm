@@ -1,21 +1,216 @@
 module;
 
-#include <vector>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 
 export module obc.scanner;
 
 export import :token;
+export import :token_queue;
+// Interface partitions must all be exported by the primary interface - but these ones export
+// no declarations of their own, so their helpers stay out of reach of the importers of the
+// module.
+export import :source_index;
+export import :token_utils;
 import obc.error_info;
 
 namespace obc {
 
+    // Value of a maximum number of errors that stands for no limit at all.
+    export constexpr std::size_t NO_ERRORS_LIMIT{0U};
+
     export struct ScanResults {
         std::vector<Token> tokens;
         std::vector<ErrorInfo> errors;
     };
 
-    struct ScanContext;
+    /**
+     * Context of an ongoing scan operation. Each scan operation creates an
+     * instance of ScanContext at its start - or resets the one kept by a ScanSession. The
+     * context stores bookkeeping data for the scan process and is passed around (and modified)
+     * by the different methods of the Scanner class. All of it is usable in constant
+     * evaluation, so sources can also be scanned at compile time.
+     */
+    struct ScanContext {
+        // The source input being scanned.
+        // A string_view here is safe - a ScanContext is reset before every scan operation
+        // and the input is not accessed after the operation finishes. The string_view allows
+        // avoiding both copying strings and having to declare a const data member.
+        std::string_view srcInput;
+        // Use lowercase keyword?
+        bool lowerCaseKeywords;
+        // Maximum number of errors to be found before the scan is stopped (NO_ERRORS_LIMIT
+        // for no limit).
+        std::size_t maxErrors;
+        // Has a '\t' been found in the src input? (Look in the currColumn description for
+        // more details)
+        bool srcHasTab{false};
+        // Index of the src input, built by a single sweep over it before it is scanned - or,
+        // on a streaming scan, over each window of it as the window is filled in.
+        SourceIndex srcIndex;
+        // Position, in the invalid offsets of srcIndex, of the next invalid byte to be reached
+        // by the scan.
+        std::size_t nextInvalidOffset{0};
+        // Stream the src input is read from, on a streaming scan. Null for a scan whose whole
+        // src input is already in memory.
+        std::istream* srcStream{nullptr};
+        // Fixed-size window over the src stream, refilled as the scan progresses. On a
+        // streaming scan, srcInput views the part of the window filled in by the last read.
+        std::vector<char> srcWindow;
+        // Number of bytes, right after srcInput in the window, that start a UTF-8 sequence the
+        // last read has cut short. They are carried over to the start of the window by the
+        // next refill, so a sequence is always indexed and scanned as a whole.
+        std::size_t srcWindowCarry{0};
+        // Index, in the whole src input, of the first character viewed by srcInput.
+        std::size_t srcInputBase{0};
+        // Index, in srcInput, of the character being scanned.
+        unsigned long lexPos{0};
+        // Number of the line from the src input currently being scanned.
+        int currLine{1};
+        // Number of the column (of the current line) from the src input currently
+        // being scanned - in characters, not in bytes. Column information should be
+        // ignored if there's at least one '\t' in the source file.
+        int currColumn{1};
+        // The tokens (and errors) found by the ongoing scan operation.
+        ScanResults results;
+        // Queue the tokens are handed over to, in batches, on a pipelined scan. Null for a
+        // scan that collects all the tokens in results.
+        TokenQueue* tokenQueue{nullptr};
+
+        constexpr ScanContext(const std::string_view srcInput, const bool lowerKey,
+                    const std::size_t maxErrors)
+            : srcInput{srcInput}, lowerCaseKeywords{lowerKey}, maxErrors{maxErrors} {}
+
+        /**
+         * Prepares the context for a new scan operation. The results lists are emptied, but
+         * keep their already allocated capacity.
+         */
+        constexpr void reset(const std::string_view newSrcInput) {
+            srcInput = newSrcInput;
+            srcHasTab = false;
+            nextInvalidOffset = 0;
+            srcWindowCarry = 0;
+            srcInputBase = 0;
+            lexPos = 0;
+            currLine = 1;
+            currColumn = 1;
+            results.tokens.clear();
+            results.errors.clear();
+        }
+
+        /**
+         * Returns the index, in the whole src input, of the next character to be scanned.
+         */
+        constexpr std::size_t scanOffset() const { return srcInputBase + lexPos; }
+
+        /**
+         * Records an error found at the current line and column of the scan.
+         *
+         * @param offset index, in the whole src input, of the first byte of the offending
+         * lexeme (or of the offending byte).
+         */
+        constexpr void addError(const ErrorCode code, const std::size_t offset,
+                                const int arg = 0) {
+            results.errors.emplace_back(ErrorInfo{.code = code,
+                                                  .line = currLine,
+                                                  .column = currColumn,
+                                                  .arg = arg,
+                                                  .offset = offset});
+        }
+
+        constexpr bool errorsLimitReached() const {
+            return maxErrors != NO_ERRORS_LIMIT && results.errors.size() >= maxErrors;
+        }
+
+        /**
+         * Returns the number of errors that can still be found before the scan is stopped.
+         */
+        constexpr std::size_t errorsLeft() const {
+            if (maxErrors == NO_ERRORS_LIMIT) {
+                return std::numeric_limits<std::size_t>::max();
+            }
+            return errorsLimitReached() ? 0 : maxErrors - results.errors.size();
+        }
+    };
+
+    /**
+     * @brief A source embedded in the program as a string literal, to be scanned at compile
+     * time.
+     *
+     * @tparam N the size of the string literal, including its terminating '\0'.
+     */
+    export template <std::size_t N>
+    struct EmbeddedSrc {
+        std::array<char, N> chars{};
+
+        // Implicit by design: allows string literals to be given directly as template
+        // arguments of Scanner::scanEmbedded.
+        // NOLINTNEXTLINE(*-explicit-constructor, *-explicit-conversions, *-avoid-c-arrays)
+        consteval EmbeddedSrc(const char (&src)[N]) { std::copy_n(src, N, chars.begin()); }
+
+        constexpr std::string_view view() const { return {chars.data(), N - 1}; }
+    };
+
+    /**
+     * A token found by a compile-time scan. Its lexeme is stored in the lexemes pool of the
+     * results the token belongs to.
+     */
+    export struct EmbeddedToken {
+        TokenType type;
+        std::size_t lexemeStart;
+        std::size_t lexemeSize;
+        int line;
+    };
+
+    /**
+     * @brief The results of a compile-time scan: the tokens found in the scanned source and
+     * the number of lexical errors in it.
+     *
+     * @tparam NTokens the number of tokens found in the source.
+     * @tparam NLexemeChars the number of characters in all the lexemes of the tokens.
+     */
+    export template <std::size_t NTokens, std::size_t NLexemeChars>
+    struct EmbeddedScanResults {
+        std::array<EmbeddedToken, NTokens> tokens{};
+        // The lexemes of all the tokens, one after the other, without any separator.
+        std::array<char, NLexemeChars> lexemes{};
+        std::size_t errorCount{0};
+
+        constexpr std::string_view lexeme(const EmbeddedToken& token) const {
+            return std::string_view{lexemes.data(), lexemes.size()}.substr(token.lexemeStart,
+                                                                            token.lexemeSize);
+        }
+
+        /**
+         * @brief Converts the tokens of the results into ordinary tokens - like the ones
+         * returned by a scan at runtime.
+         */
+        std::vector<Token> toTokens() const {
+            std::vector<Token> res;
+            res.reserve(NTokens);
+            for (const EmbeddedToken& token : tokens) {
+                res.emplace_back(Token{.type = token.type,
+                                       .lexeme = std::string{lexeme(token)},
+                                       .line = token.line});
+            }
+            return res;
+        }
+    };
+
+    // The sizes of the results of a compile-time scan.
+    struct EmbeddedScanSizes {
+        std::size_t tokenCount;
+        std::size_t lexemeChars;
+    };
 
     export class Scanner {
        public:
@@ -24,6 +219,7 @@ namespace obc {
          *
          * @param srcFilePath the path of the source file to be scanned.
          * @param lowerCaseKeywords use lowercase keywords?
+         * @param maxErrors maximum number of errors to be found before the scan is stopped.
          *
          * @return list of tokens (and the lexical errors) in the file.
          *
@@ -31,22 +227,160 @@ namespace obc {
          * opinions against all upper case keywords.
          */
         static ScanResults scanSrcFile(const std::string& srcFilePath,
-                                       bool lowerCaseKeywords = false);
+                                       bool lowerCaseKeywords = false,
+                                       std::size_t maxErrors = NO_ERRORS_LIMIT);
 
         /**
          * @brief Scans a string with the contents of a source file.
          *
          * @param src the contents of a source file.
          * @param lowerCaseKeywords use lowercase keywords?
+         * @param maxErrors maximum number of errors to be found before the scan is stopped.
          *
          * @return list of tokens (and the lexical errors) in the contents.
          *
          * @note Lower case keywords mode has been introduced because of the high number of
          * opinions against all upper case keywords.
          */
-        static ScanResults scan(const std::string& src, bool lowerCaseKeywords = false);
+        static ScanResults scan(const std::string& src, bool lowerCaseKeywords = false,
+                                std::size_t maxErrors = NO_ERRORS_LIMIT);
+
+        /**
+         * @brief Scans a given source file, handing the tokens found in it over to a consumer
+         * in batches, as the scan progresses.
+         *
+         * Meant to be called from a thread other than the consumer's, allowing the scan and
+         * the parse of a source file to overlap. The queue is closed once the scan finishes.
+         *
+         * @param srcFilePath the path of the source file to be scanned.
+         * @param tokenQueue the queue through which the tokens are handed over.
+         * @param lowerCaseKeywords use lowercase keywords?
+         * @param maxErrors maximum number of errors to be found before the scan is stopped.
+         *
+         * @return the lexical errors in the file - the tokens list of the results is empty, as
+         * all the tokens have been pushed into the queue.
+         */
+        static ScanResults scanSrcFile(const std::string& srcFilePath, TokenQueue& tokenQueue,
+                                       bool lowerCaseKeywords = false,
+                                       std::size_t maxErrors = NO_ERRORS_LIMIT);
+
+        /**
+         * @brief Scans a string with the contents of a source file, handing the tokens found
+         * in it over to a consumer in batches, as the scan progresses.
+         *
+         * Meant to be called from a thread other than the consumer's, allowing the scan and
+         * the parse of a source file to overlap. The queue is closed once the scan finishes.
+         *
+         * @param src the contents of a source file.
+         * @param tokenQueue the queue through which the tokens are handed over.
+         * @param lowerCaseKeywords use lowercase keywords?
+         * @param maxErrors maximum number of errors to be found before the scan is stopped.
+         *
+         * @return the lexical errors in the contents - the tokens list of the results is
+         * empty, as all the tokens have been pushed into the queue.
+         */
+        static ScanResults scan(const std::string& src, TokenQueue& tokenQueue,
+                                bool lowerCaseKeywords = false,
+                                std::size_t maxErrors = NO_ERRORS_LIMIT);
+
+        /**
+         * @brief Scans a stream with the contents of a source file - e.g., the standard input
+         * or a pipe.
+         *
+         * The stream is read through a fixed-size window, refilled as the scan progresses, so
+         * the memory used for holding the source doesn't depend on the size of the source -
+         * the tokens and errors found in it are still all kept in the results, though.
+         *
+         * @param srcStream the stream with the contents of a source file.
+         * @param lowerCaseKeywords use lowercase keywords?
+         * @param maxErrors maximum number of errors to be found before the scan is stopped.
+         *
+         * @return list of tokens (and the lexical errors) in the stream.
+         */
+        static ScanResults scanStream(std::istream& srcStream, bool lowerCaseKeywords = false,
+                                      std::size_t maxErrors = NO_ERRORS_LIMIT);
+
+        /**
+         * @brief Scans a stream with the contents of a source file - e.g., the standard input
+         * or a pipe - handing the tokens found in it over to a consumer in batches, as the scan
+         * progresses.
+         *
+         * The stream is read through a fixed-size window, refilled as the scan progresses, so
+         * the memory used for holding the source doesn't depend on the size of the source.
+         * The tokens only take up the batches in the queue - but they pile up on the consumer
+         * side unless it discards them, and the errors are all kept in the results. The queue
+         * is closed once the scan finishes.
+         *
+         * @param srcStream the stream with the contents of a source file.
+         * @param tokenQueue the queue through which the tokens are handed over.
+         * @param lowerCaseKeywords use lowercase keywords?
+         * @param maxErrors maximum number of errors to be found before the scan is stopped.
+         *
+         * @return the lexical errors in the stream - the tokens list of the results is empty,
+         * as all the tokens have been pushed into the queue.
+         */
+        static ScanResults scanStream(std::istream& srcStream, TokenQueue& tokenQueue,
+                                      bool lowerCaseKeywords = false,
+                                      std::size_t maxErrors = NO_ERRORS_LIMIT);
+
+        /**
+         * @brief Scans, at compile time, a source embedded in the program as a string literal.
+         *
+         * Meant for sources known at build time - e.g., built-in modules - whose tokens can
+         * then be baked into the binary instead of being scanned at every startup:
+         *
+         *     static constexpr auto prelude = Scanner::scanEmbedded<"MODULE P; END P.">();
+         *     static_assert(prelude.errorCount == 0);
+         *
+         * @tparam src the source to be scanned.
+         * @tparam lowerCaseKeywords use lowercase keywords?
+         *
+         * @return list of tokens (and the number of lexical errors) in the source.
+         */
+        template <EmbeddedSrc src, bool lowerCaseKeywords = false>
+        static consteval auto scanEmbedded();
 
        private:
+        friend class ScanSession;
+
+        /**
+         * @brief Returns the sizes of the results of a compile-time scan of a source.
+         *
+         * @param src the source to be scanned.
+         * @param lowerCaseKeywords use lowercase keywords?
+         */
+        static constexpr EmbeddedScanSizes embeddedScanSizes(std::string_view src,
+                                                             bool lowerCaseKeywords);
+
+        /**
+         * @brief Loads the contents of a source file into primary memory.
+         *
+         * @param srcFilePath the path of the source file to be loaded.
+         * @param src receives the contents of the source file.
+         * @param errors receives the errors that prevented the file from being loaded.
+         *
+         * @return true if the source file has been loaded; false otherwise.
+         */
+        static bool loadSrcFile(const std::string& srcFilePath, std::string& src,
+                                std::vector<ErrorInfo>& errors);
+
+        /**
+         * @brief Scans the whole src input of a scan operation, ending it with the
+         * End-of-Module token.
+         *
+         * @param ctx the context of the scan operation.
+         */
+        static constexpr void scanAll(ScanContext& ctx);
+
+        /**
+         * @brief Hands the tokens found so far over to the context's token queue, if the scan
+         * operation is a pipelined one.
+         *
+         * @param ctx the context of the ongoing scan operation.
+         * @param force hand the tokens over even if they don't fill up a whole batch?
+         */
+        static constexpr void flushTokens(ScanContext& ctx, bool force);
+
         /**
          * @brief Scans the next token from the src input.
          *
@@ -54,24 +388,38 @@ namespace obc {
          *
          * @param ctx the context of the ongoing scan operation.
          */
-        static void scanNextToken(ScanContext& ctx);
+        static constexpr void scanNextToken(ScanContext& ctx);
 
         /**
          * @brief Returns whether the whole src input has been already scanned or not.
          *
+         * On a streaming scan, the window over the src stream is refilled when all its
+         * characters have already been scanned.
+         *
          * @param ctx  the context of the ongoing scan operation.
          * @return true: all the characters from the src input have already been scanned.
          * @return false: there is at least one more character from the src input to be scanned.
          */
-        static bool allScanned(const ScanContext& ctx);
+        static constexpr bool allScanned(ScanContext& ctx);
+
+        /**
+         * @brief Refills the window over the src stream of a streaming scan with the next
+         * characters read from the stream.
+         *
+         * @param ctx the context of the ongoing scan operation.
+         * @return true if there is at least one more character to be scanned in the window.
+         * @return false if the end of the stream has been reached (or it could not be read).
+         */
+        static bool refillSrcWindow(ScanContext& ctx);
 
         /**
          * @brief Returns the next character in the source being scanned and advances the scan
          * by one character.
          * @param ctx the context of the ongoing scan operation.
-         * @return the next character in the source being scanned.
+         * @return the next character in the source being scanned. If the end of the input has
+         * been reached, it returns '\0'.
          */
-        static char nextChr(ScanContext& ctx);
+        static constexpr char nextChr(ScanContext& ctx);
 
         /**
          * @brief Returns the next character in the source being scanned but doesn't advance
@@ -81,7 +429,7 @@ namespace obc {
          * @return The next character in the source being scanned. If the end of the input has
          * been reached, it returns '\0'.
          */
-        static char nextChrNoAdvance(const ScanContext& ctx);
+        static constexpr char nextChrNoAdvance(ScanContext& ctx);
 
         /**
          * @brief Returns whether the next character matches an expected character or not.
@@ -93,7 +441,38 @@ namespace obc {
          * @param expChr the expected character after the current one.
          * @return true if the next character matches the expected character.
          */
-        static bool nextChrMatch(ScanContext& ctx, char expChr);
+        static constexpr bool nextChrMatch(ScanContext& ctx, char expChr);
+
+        /**
+         * @brief Returns whether the byte at a given position of the src input has been
+         * flagged by the index of the src input as not being part of a valid UTF-8 sequence.
+         *
+         * @attention The positions given to consecutive calls within a scan must not decrease.
+         *
+         * @param ctx the context of the ongoing scan operation.
+         * @param pos the position, in the src input, of the byte.
+         */
+        static constexpr bool invalidByteAt(ScanContext& ctx, std::size_t pos);
+
+        /**
+         * @brief Advances the current column past the byte at the scan position, inside a
+         * comment or a string literal.
+         *
+         * The continuation bytes of a valid UTF-8 sequence don't take a column of their own.
+         * A byte that is not part of a valid UTF-8 sequence is reported as an error.
+         *
+         * @param ctx the context of the ongoing scan operation.
+         */
+        static constexpr void advanceColumn(ScanContext& ctx);
+
+        /**
+         * @brief Reports a non-ASCII character found outside comments and string literals -
+         * either a whole UTF-8 sequence, consumed as a single character, or an invalid byte.
+         *
+         * @param ctx the context of the ongoing scan operation, right after the first byte of
+         * the character.
+         */
+        static constexpr void reportNonAsciiChar(ScanContext& ctx);
 
         /**
          * @brief Consumes the scanning input until an end of comment sequence, "*)", is found.
@@ -103,7 +482,7 @@ namespace obc {
          *
          * @param ctx the context of the ongoing scan operation.
          */
-        static void consumeComment(ScanContext& ctx);
+        static constexpr void consumeComment(ScanContext& ctx);
 
         /**
          * @brief Consumes the scanning input until an end of string character (the double
@@ -117,7 +496,7 @@ namespace obc {
          * @param ctx the context of the ongoing scan operation.
          *
          */
-        static void scanString(ScanContext& ctx);
+        static constexpr void scanString(ScanContext& ctx);
 
         /**
          * @brief Scans an identifier - sequence of letters and digits initiated by a letter.
@@ -128,7 +507,7 @@ namespace obc {
          * @param ctx the context of the ongoing scan operation.
          * @param firstLetter the first letter of the identifier.
          */
-        static void scanIdentifier(ScanContext& ctx, char firstLetter);
+        static constexpr void scanIdentifier(ScanContext& ctx, char firstLetter);
 
         /**
          * @brief Scans a number - sequence of digits optionally in hexadecimal form - or a
@@ -138,7 +517,7 @@ namespace obc {
          * @param ctx the context of the ongoing scan operation.
          * @param firstDigit the first digit of the number.
          */
-        static void scanNumberOrSingleCharString(ScanContext& ctx, char firstDigit);
+        static constexpr void scanNumberOrSingleCharString(ScanContext& ctx, char firstDigit);
 
         /**
          * @brief Scans a real number - sequence of digits in base 10 with a decimal separator.
@@ -152,7 +531,7 @@ namespace obc {
          * @param integerPart the integer part of the real number (includes the decimal
          * separator).
          */
-        static void scanRealNumber(ScanContext& ctx, const std::string& integerPart);
+        static constexpr void scanRealNumber(ScanContext& ctx, const std::string& integerPart);
 
         /**
          * @brief Scans the optional scale factor at the end of a real number literal.
@@ -162,7 +541,8 @@ namespace obc {
          * of the real number literal - the scanner can only know that the literal has a scale
          * factor when it finds the introducing 'E' of the exponential notation.
          */
-        static void scanRealScaleFactor(ScanContext& ctx, const std::string& realBasePart);
+        static constexpr void scanRealScaleFactor(ScanContext& ctx,
+                                                  const std::string& realBasePart);
 
         /**
          * Handles potential two-char tokens by looking ahead to the next character in the source
@@ -176,7 +556,541 @@ namespace obc {
          * two-character token.
          * @param ctx the context of the ongoing scan operation.
          */
-        static void handleTwoCharTokens(char firstChr, enum TokenType expectTokenType,
-                                        char expectSecondChr, ScanContext& ctx);
+        static constexpr void handleTwoCharTokens(char firstChr, enum TokenType expectTokenType,
+                                                  char expectSecondChr, ScanContext& ctx);
+    };
+
+    /**
+     * @brief A reusable scanner for processes that scan many (usually small) source modules.
+     *
+     * A session keeps its scan context - including the token and error lists - alive between
+     * scan operations, so the memory already allocated for them is reused by the next scan
+     * instead of being allocated again from scratch.
+     */
+    export class ScanSession {
+       public:
+        /**
+         * @param lowerCaseKeywords use lowercase keywords in all the scans of the session?
+         * @param maxErrors maximum number of errors to be found by a scan of the session
+         * before it is stopped.
+         */
+        explicit ScanSession(bool lowerCaseKeywords = false,
+                             std::size_t maxErrors = NO_ERRORS_LIMIT);
+        ~ScanSession();
+
+        ScanSession(const ScanSession&) = delete;
+        ScanSession& operator=(const ScanSession&) = delete;
+        ScanSession(ScanSession&&) noexcept;
+        ScanSession& operator=(ScanSession&&) noexcept;
+
+        /**
+         * @brief Scans a string with the contents of a source file.
+         *
+         * @param src the contents of a source file.
+         *
+         * @return list of tokens (and the lexical errors) in the contents.
+         *
+         * @attention The returned results are owned by the session and are only valid until
+         * its next scan operation. Copy them if they must outlive it - or use scanMany, which
+         * hands out results of their own.
+         */
+        const ScanResults& scan(const std::string& src);
+
+        /**
+         * @brief Scans the contents of a batch of source files.
+         *
+         * Every source is scanned into the lists kept by the session, which only grow when a
+         * source has more tokens (or errors) than any source scanned before. The results of
+         * each source are then moved into lists sized to their contents - so a large source
+         * doesn't inflate the results of the smaller ones.
+         *
+         * @param srcs the contents of the source files.
+         *
+         * @return list of tokens (and the lexical errors) for each one of the sources, in the
+         * same order as the sources.
+         */
+        std::vector<ScanResults> scanMany(std::span<const std::string> srcs);
+
+       private:
+        std::unique_ptr<ScanContext> m_ctx;
     };
+
+    template <EmbeddedSrc src, bool lowerCaseKeywords>
+    consteval auto Scanner::scanEmbedded() {
+        // The sizes of the results must be known before the results can be declared - the
+        // source is scanned once just for finding them out.
+        constexpr EmbeddedScanSizes sizes = embeddedScanSizes(src.view(), lowerCaseKeywords);
+        EmbeddedScanResults<sizes.tokenCount, sizes.lexemeChars> res{};
+
+        ScanContext ctx(src.view(), lowerCaseKeywords, NO_ERRORS_LIMIT);
+        scanAll(ctx);
+        std::size_t lexemeStart = 0;
+        for (std::size_t i = 0; i < ctx.results.tokens.size(); i++) {
+            const Token& token = ctx.results.tokens.at(i);
+            std::copy(token.lexeme.begin(), token.lexeme.end(),
+                      res.lexemes.begin() + static_cast<std::ptrdiff_t>(lexemeStart));
+            res.tokens.at(i) = EmbeddedToken{.type = token.type,
+                                             .lexemeStart = lexemeStart,
+                                             .lexemeSize = token.lexeme.size(),
+                                             .line = token.line};
+            lexemeStart += token.lexeme.size();
+        }
+        res.errorCount = ctx.results.errors.size();
+        return res;
+    }
+
+    constexpr EmbeddedScanSizes Scanner::embeddedScanSizes(const std::string_view src,
+                                                           const bool lowerCaseKeywords) {
+        ScanContext ctx(src, lowerCaseKeywords, NO_ERRORS_LIMIT);
+        scanAll(ctx);
+        EmbeddedScanSizes sizes{.tokenCount = ctx.results.tokens.size(), .lexemeChars = 0};
+        for (const Token& token : ctx.results.tokens) {
+            sizes.lexemeChars += token.lexeme.size();
+        }
+        return sizes;
+    }
+
+    constexpr void Scanner::scanAll(ScanContext& ctx) {
+        if (ctx.srcStream == nullptr) {
+            // The whole src input is in memory - its tabs and encoding are checked by a single
+            // sweep over it before the scan starts. The windows of a streaming scan are
+            // checked as they are filled in.
+            ctx.srcIndex.build(ctx.srcInput, ctx.errorsLeft());
+            ctx.srcHasTab = ctx.srcIndex.hasTab;
+        }
+        while (!allScanned(ctx) && !ctx.errorsLimitReached()) {
+            scanNextToken(ctx);
+            flushTokens(ctx, false);
+        }
+        if (ctx.errorsLimitReached()) {
+            // A single token may have raised more than one error - only the errors up to the
+            // limit are kept, followed by the one signaling the early stop of the scan.
+            ctx.results.errors.resize(ctx.maxErrors);
+            ctx.results.errors.emplace_back(
+                  ErrorInfo{.code = ErrorCode::TOO_MANY_ERRORS,
+                            .line = ctx.currLine,
+                            .column = ctx.currColumn,
+                            .arg = static_cast<int>(std::min<std::size_t>(
+                                  ctx.maxErrors, std::numeric_limits<int>::max())),
+                            .offset = ctx.scanOffset()});
+        }
+
+        // An End-of-Module is always inserted to provide a clear indicator for the parser.
+        ctx.results.tokens.emplace_back(
+              Token{.type = TokenType::EOM, .lexeme = "", .line = ctx.currLine});
+        flushTokens(ctx, true);
+
+        // Current column information should be ignored when the source file has at least one
+        // tab: The information of how many columns correspond to a '\t' is not in the source
+        // file and cannot be easily inferred. On a streaming scan, tabs are detected as the
+        // windows are filled in, so the columns already recorded must be dropped once the
+        // whole input has been seen.
+        if (ctx.srcHasTab) {
+            for (ErrorInfo& error : ctx.results.errors) {
+                error.column = -1;
+            }
+        }
+    }
+
+    constexpr void Scanner::flushTokens(ScanContext& ctx, const bool force) {
+        if (ctx.tokenQueue == nullptr) {
+            return;
+        }
+        if (ctx.results.tokens.size() >= TOKEN_BATCH_SIZE ||
+            (force && !ctx.results.tokens.empty())) {
+            ctx.tokenQueue->push(ctx.results.tokens);
+        }
+    }
+
+    constexpr bool Scanner::allScanned(ScanContext& ctx) {
+        if (ctx.lexPos < ctx.srcInput.length()) {
+            return false;
+        }
+        return ctx.srcStream == nullptr || !refillSrcWindow(ctx);
+    }
+
+    constexpr char Scanner::nextChr(ScanContext& ctx) {
+        if (allScanned(ctx)) {
+            return '\0';
+        }
+        const char chr = ctx.srcInput.at(ctx.lexPos);
+        ctx.lexPos++;
+        return chr;
+    }
+
+    constexpr char Scanner::nextChrNoAdvance(ScanContext& ctx) {
+        if (allScanned(ctx)) {
+            return '\0';
+        }
+        return ctx.srcInput.at(ctx.lexPos);
+    }
+
+    constexpr bool Scanner::nextChrMatch(ScanContext& ctx, const char expChr) {
+        if (allScanned(ctx) || ctx.srcInput.at(ctx.lexPos) != expChr) {
+            return false;
+        }
+        ctx.lexPos++;
+        return true;
+    }
+
+    constexpr bool Scanner::invalidByteAt(ScanContext& ctx, const std::size_t pos) {
+        const std::vector<std::size_t>& invalidOffsets = ctx.srcIndex.invalidOffsets;
+        while (ctx.nextInvalidOffset < invalidOffsets.size() &&
+               invalidOffsets.at(ctx.nextInvalidOffset) < pos) {
+            ctx.nextInvalidOffset++;
+        }
+        return ctx.nextInvalidOffset < invalidOffsets.size() &&
+               invalidOffsets.at(ctx.nextInvalidOffset) == pos;
+    }
+
+    constexpr void Scanner::advanceColumn(ScanContext& ctx) {
+        const char chr = ctx.srcInput.at(ctx.lexPos);
+        if (isAsciiByte(chr)) {
+            ctx.currColumn++;
+        } else if (invalidByteAt(ctx, ctx.lexPos)) {
+            ctx.currColumn++;
+            if (!ctx.errorsLimitReached()) {
+                ctx.addError(ErrorCode::INVALID_ENCODING, ctx.scanOffset(),
+                             static_cast<unsigned char>(chr));
+            }
+        } else if (!isContinuationByte(chr)) {
+            ctx.currColumn++;
+        }
+    }
+
+    constexpr void Scanner::reportNonAsciiChar(ScanContext& ctx) {
+        const std::size_t chrPos = ctx.lexPos - 1;
+        // The scan isn't meant to stop in the middle of a valid UTF-8 sequence - but should it
+        // ever do so, the continuation byte it stopped at is reported as an invalid byte,
+        // instead of being taken as the start of a sequence.
+        const std::size_t length = utf8SequenceLength(ctx.srcInput, chrPos);
+        if (length == 0 || invalidByteAt(ctx, chrPos)) {
+            ctx.addError(ErrorCode::INVALID_ENCODING, ctx.srcInputBase + chrPos,
+                         static_cast<unsigned char>(ctx.srcInput.at(chrPos)));
+            return;
+        }
+        // The rest of the sequence is consumed as part of the same character.
+        ctx.lexPos = chrPos + length;
+        ctx.addError(ErrorCode::UNEXPECTED_CHAR, ctx.srcInputBase + chrPos,
+                     utf8CodePoint(ctx.srcInput, chrPos, length));
+    }
+
+    constexpr void Scanner::scanNextToken(ScanContext& ctx) {
+        switch (const char chr = nextChr(ctx)) {
+            // Handling of single-char tokens
+            case '&':
+            case ',':
+            case '=':
+            case '#':
+            case '[':
+            case '-':
+            case '+':
+            case ']':
+            case ')':
+                // A close parenthesis matched in this context won't be one of the comments
+                // terminating characters. Such a right parenthesis will be consumed by the
+                // comment-consuming loop.
+            case ';':
+            case '*':
+                // A star matched in this context won't be one of the comments terminating
+                // characters. Such stars will be consumed by the comment-consuming loop.
+            case '~':
+            case '{':
+            case '}':
+            case '^':
+                try {
+                    ctx.results.tokens.emplace_back(Token{.type = Token::typeFromChar(chr),
+                                                          .lexeme = std::string{chr},
+                                                          .line = ctx.currLine});
+                } catch (std::invalid_argument const&) {
+                    ctx.addError(ErrorCode::UNEXPECTED_CHAR, ctx.scanOffset() - 1, chr);
+                }
+                ctx.currColumn++;
+                break;
+
+            // Handling of (potentially) two-char tokens
+            case '<':
+                handleTwoCharTokens(chr, TokenType::LESS_EQUAL, '=', ctx);
+                break;
+            case '>':
+                handleTwoCharTokens(chr, TokenType::GREATER_EQUAL, '=', ctx);
+                break;
+            case ':':
+                handleTwoCharTokens(chr, TokenType::ASSIGN, '=', ctx);
+                break;
+            case '.':
+                handleTwoCharTokens(chr, TokenType::LABEL_RANGE, '.', ctx);
+                break;
+
+            // Handling of whitespace characters (except newlines) - simply consumed. Blanks are
+            // not ignored when inside strings.
+            case ' ':
+            case '\r':
+            case '\t':
+                ctx.currColumn++;
+                break;
+
+            // Handling of new lines (outside comments; the comment handler handles new lines in
+            // the middle of comments)
+            case '\n':
+                ctx.currLine++;
+                ctx.currColumn = 1;
+                break;
+
+            // Handling of (potential) comments. If the "(" is followed by a "*" and indeed
+            // starts a comment, the scanning process will be captured by the comment-consuming
+            // loop.
+            case '(':
+                if (nextChrMatch(ctx, '*')) {
+                    // Found start of comment - "consume" it.
+                    ctx.currColumn++;
+                    consumeComment(ctx);
+                    break;
+                } // Found a single-character open parenthesis token.
+                ctx.results.tokens.emplace_back(Token{.type = Token::typeFromChar(chr),
+                                                      .lexeme = std::string{chr},
+                                                      .line = ctx.currLine});
+                ctx.currColumn++;
+                break;
+
+            // Handling of string literals. String literals cannot contain internal double
+            // quotes and cannot span across multiple lines.
+            case '"':
+                ctx.currColumn++;
+                scanString(ctx);
+                break;
+
+            default:
+                ctx.currColumn++;
+                if (isLetter(chr)) {
+                    scanIdentifier(ctx, chr);
+                } else if (isDigit(chr)) {
+                    scanNumberOrSingleCharString(ctx, chr);
+                } else if (isAsciiByte(chr)) {
+                    ctx.addError(ErrorCode::UNEXPECTED_CHAR, ctx.scanOffset() - 1, chr);
+                } else {
+                    reportNonAsciiChar(ctx);
+                }
+        }
+    }
+
+    constexpr void Scanner::scanNumberOrSingleCharString(ScanContext& ctx,
+                                                         const char firstDigit) {
+        // The first digit has already been consumed.
+        const std::size_t lexemeStart = ctx.scanOffset() - 1;
+        std::string lex{firstDigit};
+        char nextChr = nextChrNoAdvance(ctx);
+        while (isHexDigit(nextChr)) {
+            lex.push_back(nextChr);
+            ctx.lexPos++;
+            ctx.currColumn++;
+            nextChr = nextChrNoAdvance(ctx);
+        }
+        if (nextChr == 'X') {
+            // The end of a single character string has been found. The character must be
+            // evaluated from the hexadecimal value given by the lexeme.
+            if (lex.size() > 2) {
+                ctx.addError(ErrorCode::INVALID_SINGLE_CHAR_STRING, lexemeStart);
+            } else {
+                const int charCode = hexValue(lex);
+                ctx.results.tokens.emplace_back(
+                      Token{.type = TokenType::STRING,
+                            .lexeme = std::string{static_cast<char>(charCode)},
+                            .line = ctx.currLine});
+            }
+            // Consume the 'X' - it is not part of the string
+            ctx.lexPos++;
+            ctx.currColumn++;
+        } else if (nextChr == 'H') {
+            // The end of an integer literal in hexadecimal form has been found - the H is part
+            // of the integer literal and must be included in its lexeme.
+            lex.push_back(nextChr);
+            ctx.lexPos++;
+            ctx.currColumn++;
+            ctx.results.tokens.emplace_back(Token{
+                  .type = TokenType::INTEGER, .lexeme = std::move(lex), .line = ctx.currLine});
+        } else if (nextChr == '.') {
+            // A decimal separator indicates that a REAL literal is being scanned.
+            if (!allBase10Digits(lex)) {
+                // Oberon only allows integer numbers to be represented in hex. Real numbers
+                // must always be expressed in base 10.
+                ctx.addError(ErrorCode::NON_DECIMAL_REAL, lexemeStart);
+            }
+            lex.push_back(nextChr);
+            ctx.lexPos++;
+            ctx.currColumn++;
+            scanRealNumber(ctx, lex);
+        } else {
+            // The lexeme found so far can be an integer literal in decimal form - unless it
+            // contains any hexadecimal digit that is not a base 10 digit.
+            if (allBase10Digits(lex)) {
+                // The lexeme is a valid integer literal in decimal form.
+                ctx.results.tokens.emplace_back(Token{.type = TokenType::INTEGER,
+                                                      .lexeme = std::move(lex),
+                                                      .line = ctx.currLine});
+            } else {
+                // A hexadecimal digit that is not a base 10 digit has been found; report the
+                // error.
+                ctx.addError(ErrorCode::UNTERMINATED_HEX_INTEGER, lexemeStart);
+            }
+        }
+    }
+
+    constexpr void Scanner::scanRealNumber(ScanContext& ctx, const std::string& integerPart) {
+        std::string lex{integerPart};
+        char nextChr = nextChrNoAdvance(ctx);
+        while (isDigit(nextChr)) {
+            lex.push_back(nextChr);
+            ctx.lexPos++;
+            ctx.currColumn++;
+            nextChr = nextChrNoAdvance(ctx);
+        }
+        if (nextChr == 'E') {
+            // Found the optional scale factor at the end.
+            lex.push_back(nextChr);
+            ctx.lexPos++;
+            ctx.currColumn++;
+            scanRealScaleFactor(ctx, lex);
+        } else {
+            ctx.results.tokens.emplace_back(Token{
+                  .type = TokenType::REAL, .lexeme = std::move(lex), .line = ctx.currLine});
+        }
+    }
+
+    constexpr void Scanner::scanRealScaleFactor(ScanContext& ctx,
+                                                const std::string& realBasePart) {
+        // All the characters of the real number so far have already been consumed.
+        const std::size_t lexemeStart = ctx.scanOffset() - realBasePart.size();
+        std::string lex{realBasePart};
+        // Takes the next character of the scale factor. A non-ASCII character is left to be
+        // scanned on its own, as a whole - taking just its first byte would leave the scan in
+        // the middle of it.
+        const auto nextAsciiChr = [&ctx] {
+            if (!isAsciiByte(nextChrNoAdvance(ctx))) {
+                return '\0';
+            }
+            ctx.currColumn++;
+            return nextChr(ctx);
+        };
+        char nextCh = nextAsciiChr();
+        if (nextCh != '+' && nextCh != '-') {
+            ctx.addError(ErrorCode::INVALID_SCALE_FACTOR_SIGN, lexemeStart);
+        } else {
+            lex.push_back(nextCh);
+            nextCh = nextAsciiChr();
+            if (!isDigit(nextCh)) {
+                ctx.addError(ErrorCode::MISSING_SCALE_FACTOR_DIGITS, lexemeStart);
+            } else {
+                lex.push_back(nextCh);
+                nextCh = nextChrNoAdvance(ctx);
+                while (isDigit(nextCh)) {
+                    lex.push_back(nextCh);
+                    ctx.lexPos++;
+                    ctx.currColumn++;
+                    nextCh = nextChrNoAdvance(ctx);
+                }
+                ctx.results.tokens.push_back(Token{
+                      .type = TokenType::REAL, .lexeme = std::move(lex), .line = ctx.currLine});
+            }
+        }
+    }
+
+    constexpr void Scanner::scanIdentifier(ScanContext& ctx, const char firstLetter) {
+        std::string identLex{firstLetter};
+        char nextChr = nextChrNoAdvance(ctx);
+        while (isLetter(nextChr) || isDigit(nextChr)) {
+            identLex.push_back(nextChr);
+            ctx.lexPos++;
+            ctx.currColumn++;
+            nextChr = nextChrNoAdvance(ctx);
+        }
+        const TokenType tkType =
+              Token::typeFromIdentifierLexeme(ctx.lowerCaseKeywords, identLex);
+        ctx.results.tokens.emplace_back(Token{
+              .type = tkType, .lexeme = std::move(identLex), .line = ctx.currLine});
+    }
+
+    constexpr void Scanner::consumeComment(ScanContext& ctx) {
+        // The "(*" starting the comment has already been consumed.
+        const std::size_t commentStart = ctx.scanOffset() - 2;
+        bool endOfCommentFound = false;
+        while (!allScanned(ctx)) {
+            // As comments can be "surrounded" by real code (in Oberon-07, comments are not
+            // ended by line breaks), the line and column information must be updated.
+            if (nextChrNoAdvance(ctx) == '\n') {
+                ctx.currLine++;
+                ctx.currColumn = 1;
+            } else {
+                advanceColumn(ctx);
+                if (ctx.errorsLimitReached()) {
+                    // The scan is being stopped - the rest of the comment isn't looked at.
+                    return;
+                }
+            }
+            const bool starFound = nextChrNoAdvance(ctx) == '*';
+            ctx.lexPos++;
+            // After a "*", there's a chance that the end of comment has been reached. If the
+            // next character isn't a ")", it is left to the next iteration - to be checked
+            // like any other character of the comment.
+            if (starFound && nextChrMatch(ctx, ')')) {
+                ctx.currColumn++;
+                endOfCommentFound = true;
+                break; // Break-out of the comment-consuming loop
+            }
+        }
+        if (!endOfCommentFound) {
+            // If the end of the comment has not been found at this point, it means we
+            // have an unfinished comment.
+            ctx.addError(ErrorCode::UNFINISHED_COMMENT, commentStart);
+        }
+    }
+
+    constexpr void Scanner::scanString(ScanContext& ctx) {
+        // The opening double quotes have already been consumed.
+        const std::size_t stringStart = ctx.scanOffset() - 1;
+        std::string strLex{};
+        while (!allScanned(ctx)) {
+            if (const char nextChr = nextChrNoAdvance(ctx); nextChr != '\n' && nextChr != '"') {
+                // In the middle of the string literal - just keep on acquiring the lexeme
+                advanceColumn(ctx);
+                if (ctx.errorsLimitReached()) {
+                    // The scan is being stopped - the rest of the string isn't looked at.
+                    return;
+                }
+                strLex.push_back(nextChr);
+                ctx.lexPos++;
+            } else {
+                if (nextChr == '\n') {
+                    ctx.addError(ErrorCode::UNTERMINATED_STRING, stringStart);
+                } else {
+                    // Double-quotes (End of string literal) found
+                    ctx.lexPos++;
+                    ctx.currColumn++;
+                    ctx.results.tokens.emplace_back(Token{.type = TokenType::STRING,
+                                                          .lexeme = std::move(strLex),
+                                                          .line = ctx.currLine});
+                }
+                break;
+            }
+        }
+    }
+
+    constexpr void Scanner::handleTwoCharTokens(const char firstChr,
+                                                const TokenType expectTokenType,
+                                                const char expectSecondChr, ScanContext& ctx) {
+        std::string twoChrLex{firstChr};
+        if (nextChrMatch(ctx, expectSecondChr)) {
+            twoChrLex += expectSecondChr;
+            ctx.results.tokens.emplace_back(Token{.type = expectTokenType,
+                                                  .lexeme = std::move(twoChrLex),
+                                                  .line = ctx.currLine});
+            ctx.currColumn += 2;
+        } else {
+            ctx.results.tokens.emplace_back(Token{.type = Token::typeFromChar(firstChr),
+                                                  .lexeme = std::string{firstChr},
+                                                  .line = ctx.currLine});
+            ctx.currColumn++;
+        }
+    }
+
 } // namespace obc
@@ -0,0 +1,232 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+export module obc.scanner:source_index;
+
+namespace obc {
+
+    // Number of source bytes checked at once by the word-at-a-time sweep of SourceIndex.
+    constexpr std::size_t SWEEP_WORD_SIZE{sizeof(std::uint64_t)};
+    // Maximum length of a UTF-8 sequence, in bytes.
+    constexpr std::size_t MAX_SEQUENCE_LENGTH{4U};
+
+    constexpr std::uint64_t LOW_BITS{0x0101010101010101ULL};  // The lowest bit of each byte
+    constexpr std::uint64_t HIGH_BITS{0x8080808080808080ULL}; // The highest bit of each byte
+
+    /**
+     * @brief Returns whether any of the bytes in a word is equal to a given byte.
+     *
+     * @param word the bytes to be checked, packed in a word.
+     * @param byte the byte to be looked for.
+     */
+    constexpr bool wordHasByte(const std::uint64_t word, const unsigned char byte) {
+        // Only the bytes of the word equal to the given byte are zeroed by the xor - and only
+        // a zero byte can borrow into its highest bit without having it already set.
+        const std::uint64_t diff = word ^ (LOW_BITS * byte);
+        return ((diff - LOW_BITS) & ~diff & HIGH_BITS) != 0;
+    }
+
+    /**
+     * @brief Returns whether a given char is an ASCII character or not.
+     */
+    constexpr bool isAsciiByte(const char chr) {
+        return static_cast<unsigned char>(chr) < 0x80U;
+    }
+
+    /**
+     * @brief Returns whether a given char is a continuation byte - i.e., one of the bytes after
+     * the first one - of a UTF-8 sequence.
+     */
+    constexpr bool isContinuationByte(const char chr) {
+        return (static_cast<unsigned char>(chr) & 0xC0U) == 0x80U;
+    }
+
+    /**
+     * @brief Returns the length of the valid UTF-8 sequence starting at a given position of a
+     * source, following RFC 3629: overlong forms, surrogates and code points beyond U+10FFFF
+     * are all invalid.
+     *
+     * @param src the source.
+     * @param pos the position of the first byte of the sequence.
+     * @return the length (1 to 4) of the sequence; 0 if the bytes at pos don't form a valid
+     * sequence.
+     */
+    constexpr std::size_t utf8SequenceLength(const std::string_view src,
+                                             const std::size_t pos) {
+        const auto byteAt = [src](const std::size_t idx) -> unsigned {
+            return idx < src.size() ? static_cast<unsigned char>(src[idx]) : 0U;
+        };
+        const auto inRange = [](const unsigned byte, const unsigned low, const unsigned high) {
+            return byte >= low && byte <= high;
+        };
+        const unsigned lead = byteAt(pos);
+        if (lead < 0x80U) {
+            return 1;
+        }
+        if (inRange(lead, 0xC2U, 0xDFU)) {
+            return inRange(byteAt(pos + 1), 0x80U, 0xBFU) ? 2 : 0;
+        }
+        if (inRange(lead, 0xE0U, 0xEFU)) {
+            // The limits of the second byte rule out the overlong forms (after 0xE0) and the
+            // surrogates (after 0xED).
+            const unsigned low = lead == 0xE0U ? 0xA0U : 0x80U;
+            const unsigned high = lead == 0xEDU ? 0x9FU : 0xBFU;
+            return inRange(byteAt(pos + 1), low, high) &&
+                               inRange(byteAt(pos + 2), 0x80U, 0xBFU)
+                         ? 3
+                         : 0;
+        }
+        if (inRange(lead, 0xF0U, 0xF4U)) {
+            // The limits of the second byte rule out the overlong forms (after 0xF0) and the
+            // code points beyond U+10FFFF (after 0xF4).
+            const unsigned low = lead == 0xF0U ? 0x90U : 0x80U;
+            const unsigned high = lead == 0xF4U ? 0x8FU : 0xBFU;
+            return inRange(byteAt(pos + 1), low, high) &&
+                               inRange(byteAt(pos + 2), 0x80U, 0xBFU) &&
+                               inRange(byteAt(pos + 3), 0x80U, 0xBFU)
+                         ? 4
+                         : 0;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Returns the code point encoded by a valid UTF-8 sequence.
+     *
+     * @attention The caller must make sure - through utf8SequenceLength - that the bytes at
+     * pos form a valid sequence of the given length.
+     *
+     * @param src the source.
+     * @param pos the position of the first byte of the sequence.
+     * @param length the length of the sequence.
+     */
+    constexpr int utf8CodePoint(const std::string_view src, const std::size_t pos,
+                                const std::size_t length) {
+        constexpr std::array<unsigned, 5> leadMasks{0x00U, 0x7FU, 0x1FU, 0x0FU, 0x07U};
+        unsigned codePoint = static_cast<unsigned char>(src.at(pos)) & leadMasks.at(length);
+        for (std::size_t i = 1; i < length; i++) {
+            const auto contByte = static_cast<unsigned char>(src.at(pos + i));
+            codePoint = (codePoint << 6U) | (contByte & 0x3FU);
+        }
+        return static_cast<int>(codePoint);
+    }
+
+    /**
+     * @brief Returns the number of bytes at the end of a chunk of a source that start a UTF-8
+     * sequence the chunk ends before completing - so the rest of the sequence is in the next
+     * chunk of the source.
+     *
+     * @param chunk the chunk of the source.
+     * @return the number (0 to 3) of bytes the incomplete sequence has in the chunk; 0 if
+     * the chunk doesn't end in the middle of a sequence.
+     */
+    constexpr std::size_t incompleteSequenceTail(const std::string_view chunk) {
+        const std::size_t maxTail = std::min(chunk.size(), MAX_SEQUENCE_LENGTH - 1);
+        for (std::size_t tail = 1; tail <= maxTail; tail++) {
+            const char chr = chunk[chunk.size() - tail];
+            if (isContinuationByte(chr)) {
+                continue;
+            }
+            // The length a sequence starting with this byte would have, were it valid.
+            const auto lead = static_cast<unsigned char>(chr);
+            std::size_t length = 1;
+            if (lead >= 0xF0U && lead < 0xF8U) {
+                length = 4;
+            } else if (lead >= 0xE0U && lead < 0xF0U) {
+                length = 3;
+            } else if (lead >= 0xC0U && lead < 0xE0U) {
+                length = 2;
+            }
+            return length > tail ? tail : 0;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief An index of a source, built by a single sweep over it: whether it has tabs and
+     * which of its bytes are not part of valid UTF-8 sequences.
+     *
+     * The sweep checks the source a word at a time, so pure ASCII spans without tabs - most
+     * of any source - are skipped without looking at each of their bytes.
+     */
+    struct SourceIndex {
+        // Positions, in the source, of the bytes that are not part of a valid UTF-8 sequence -
+        // in increasing order.
+        std::vector<std::size_t> invalidOffsets;
+        // Has a '\t' been found in the source?
+        bool hasTab{false};
+
+        /**
+         * @brief Indexes a given source, replacing any previous contents of the index.
+         *
+         * The invalid offsets list is emptied, but keeps its already allocated capacity.
+         *
+         * @param src the source to be indexed.
+         * @param maxInvalidOffsets maximum number of invalid offsets to be kept - a scan
+         * stopped by its errors limit never gets to the invalid bytes beyond it.
+         */
+        constexpr void build(const std::string_view src, const std::size_t maxInvalidOffsets) {
+            invalidOffsets.clear();
+            hasTab = false;
+
+            std::size_t pos = 0;
+            while (pos < src.size()) {
+                if (pos + SWEEP_WORD_SIZE <= src.size() && !wordNeedsCheck(src, pos)) {
+                    pos += SWEEP_WORD_SIZE;
+                    continue;
+                }
+                // Some byte of the word (or of the last, partial word) must be looked at on its
+                // own - the whole word is then checked byte by byte.
+                const std::size_t checkEnd = std::min(pos + SWEEP_WORD_SIZE, src.size());
+                while (pos < checkEnd) {
+                    pos = indexChar(src, pos, maxInvalidOffsets);
+                }
+            }
+        }
+
+       private:
+        /**
+         * @brief Indexes the character starting at a given position of the source.
+         *
+         * @return the position of the next character in the source.
+         */
+        constexpr std::size_t indexChar(const std::string_view src, const std::size_t pos,
+                                        const std::size_t maxInvalidOffsets) {
+            const auto byte = static_cast<unsigned char>(src[pos]);
+            if (byte == '\t') {
+                hasTab = true;
+            } else if (byte >= 0x80U) {
+                if (const std::size_t length = utf8SequenceLength(src, pos); length != 0) {
+                    return pos + length;
+                }
+                if (invalidOffsets.size() < maxInvalidOffsets) {
+                    invalidOffsets.push_back(pos);
+                }
+            }
+            return pos + 1;
+        }
+
+        /**
+         * @brief Returns whether any of the bytes in the word starting at a given position
+         * must be looked at individually - a tab or a non-ASCII byte.
+         */
+        static constexpr bool wordNeedsCheck(const std::string_view src,
+                                             const std::size_t pos) {
+            // Assembled byte by byte, so it can be evaluated at compile time; compilers turn
+            // this into a single (unaligned) load.
+            std::uint64_t word = 0;
+            for (std::size_t i = 0; i < SWEEP_WORD_SIZE; i++) {
+                word |= static_cast<std::uint64_t>(static_cast<unsigned char>(src[pos + i]))
+                        << (8U * i);
+            }
+            return (word & HIGH_BITS) != 0 || wordHasByte(word, '\t');
+        }
+    };
+
+} // namespace obc
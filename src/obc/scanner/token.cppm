@@ -1,14 +1,18 @@
 module;
 
+#include <algorithm>
+#include <array>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <map>
-#include <sstream>
 #include <stdexcept>
-#include <unordered_map>
+#include <utility>
 
 export module obc.scanner:token;
 
+import :token_utils;
+
 namespace obc {
 
     export enum class TokenType : unsigned char {
@@ -53,7 +57,7 @@ namespace obc {
          * @throw invalid_argument exception if the given character does not correspond to
          * a single-char token type known to Oberon-07.
          */
-        static TokenType typeFromChar(char chr);
+        static constexpr TokenType typeFromChar(char chr);
 
         /**
          * @brief Returns the token type of the keyword that corresponds to a given lexeme.
@@ -69,7 +73,7 @@ namespace obc {
          * @param lex the lexeme whose keyword token type should be returned.
          * @return the keyword token type corresponding to the lexeme.
          */
-        static TokenType keywordTypeFromLexeme(const std::string& lex);
+        static constexpr TokenType keywordTypeFromLexeme(const std::string& lex);
 
 
         /**
@@ -81,10 +85,49 @@ namespace obc {
          * @return the token type of identifier lexeme - the lexeme can be of a language keyword
          * or of an ordinary identifier.
          */
-        static TokenType typeFromIdentifierLexeme(bool lowerCaseKeywords,
-                                                  const std::string& idLex);
+        static constexpr TokenType typeFromIdentifierLexeme(bool lowerCaseKeywords,
+                                                            const std::string& idLex);
     };
 
+    // Token types of the single-char tokens, for each one of their characters.
+    constexpr std::array<std::pair<char, TokenType>, 20> SINGLE_CHAR_TOKEN_TYPES{{
+          {'&', TokenType::AND},           {':', TokenType::COLON},
+          {',', TokenType::COMMA},         {'.', TokenType::DOT},
+          {'=', TokenType::EQUAL},         {'>', TokenType::GREATER},
+          {'#', TokenType::HASH},          {'[', TokenType::LEFT_BRACKET},
+          {'(', TokenType::LEFT_PAREN},    {'<', TokenType::LESS},
+          {'-', TokenType::MINUS},         {'+', TokenType::PLUS},
+          {']', TokenType::RIGHT_BRACKET}, {')', TokenType::RIGHT_PAREN},
+          {';', TokenType::SEMICOLON},     {'*', TokenType::STAR},
+          {'~', TokenType::TILDE},         {'^', TokenType::CIRCUMFLEX},
+          {'{', TokenType::LEFT_CURLY},    {'}', TokenType::RIGHT_CURLY}}};
+
+    // Token types of the keywords, for each one of their lexemes. Sorted by lexeme, so
+    // keywords can be looked up with a binary search.
+    constexpr std::array<std::pair<std::string_view, TokenType>, 32> KEYWORD_TYPES{{
+          {"ARRAY", TokenType::ARRAY},      {"BEGIN", TokenType::BEGIN},
+          {"CASE", TokenType::CASE},        {"CONST", TokenType::CONST},
+          {"DIV", TokenType::DIV},          {"DO", TokenType::DO},
+          {"ELSE", TokenType::ELSE},        {"ELSEIF", TokenType::ELSEIF},
+          {"END", TokenType::END},          {"FALSE", TokenType::FALSE},
+          {"FOR", TokenType::FOR},          {"IF", TokenType::IF},
+          {"IMPORT", TokenType::IMPORT},    {"IN", TokenType::IN},
+          {"IS", TokenType::IS},            {"MOD", TokenType::MOD},
+          {"MODULE", TokenType::MODULE},    {"NIL", TokenType::NIL},
+          {"OF", TokenType::OF},            {"OR", TokenType::OR},
+          {"POINTER", TokenType::POINTER},  {"PROCEDURE", TokenType::PROCEDURE},
+          {"RECORD", TokenType::RECORD},    {"REPEAT", TokenType::REPEAT},
+          {"RETURN", TokenType::RETURN},    {"THEN", TokenType::THEN},
+          {"TO", TokenType::TO},            {"TRUE", TokenType::TRUE},
+          {"TYPE", TokenType::TYPE},        {"UNTIL", TokenType::UNTIL},
+          {"VAR", TokenType::VAR},          {"WHILE", TokenType::WHILE}}};
+
+    static_assert(std::is_sorted(KEYWORD_TYPES.begin(), KEYWORD_TYPES.end(),
+                                 [](const auto& lhs, const auto& rhs) {
+                                     return lhs.first < rhs.first;
+                                 }),
+                  "KEYWORD_TYPES must be sorted by lexeme.");
+
     // Implementation for Token methods
     std::string Token::typeString() const {
         static std::map<TokenType, std::string> tokenTypeToString{
@@ -142,54 +185,29 @@ namespace obc {
         return tokenTypeToString[this->type];
     }
 
-    TokenType Token::typeFromChar(const char chr) {
-        static std::unordered_map<char, TokenType> charToSingleCharTokenType{
-              {'&', TokenType::AND},           {':', TokenType::COLON},
-              {',', TokenType::COMMA},         {'.', TokenType::DOT},
-              {'=', TokenType::EQUAL},         {'>', TokenType::GREATER},
-              {'#', TokenType::HASH},          {'[', TokenType::LEFT_BRACKET},
-              {'(', TokenType::LEFT_PAREN},    {'<', TokenType::LESS},
-              {'-', TokenType::MINUS},         {'+', TokenType::PLUS},
-              {']', TokenType::RIGHT_BRACKET}, {')', TokenType::RIGHT_PAREN},
-              {';', TokenType::SEMICOLON},     {'*', TokenType::STAR},
-              {'~', TokenType::TILDE},         {'^', TokenType::CIRCUMFLEX},
-              {'{', TokenType::LEFT_CURLY},    {'}', TokenType::RIGHT_CURLY}};
-        const auto& iter = charToSingleCharTokenType.find(chr);
-        if (iter == charToSingleCharTokenType.end()) {
-            std::ostringstream oss{"Unexpected char, '"};
-            oss << chr << "' found.";
-            throw std::invalid_argument(oss.str());
+    constexpr TokenType Token::typeFromChar(const char chr) {
+        for (const auto& [tokenChr, tokenType] : SINGLE_CHAR_TOKEN_TYPES) {
+            if (tokenChr == chr) {
+                return tokenType;
+            }
         }
-        return iter->second;
+        throw std::invalid_argument(std::string{"Unexpected char, '"} + chr + "' found.");
     }
 
-    TokenType Token::keywordTypeFromLexeme(const std::string& lex) {
-        static std::unordered_map<std::string, TokenType> lexToKeywordType{
-              {"ARRAY", TokenType::ARRAY},     {"BEGIN", TokenType::BEGIN},
-              {"CONST", TokenType::CONST},     {"DIV", TokenType::DIV},
-              {"DO", TokenType::DO},           {"ELSE", TokenType::ELSE},
-              {"ELSEIF", TokenType::ELSEIF},   {"END", TokenType::END},
-              {"IF", TokenType::IF},           {"MOD", TokenType::MOD},
-              {"MODULE", TokenType::MODULE},   {"OF", TokenType::OF},
-              {"OR", TokenType::OR},           {"PROCEDURE", TokenType::PROCEDURE},
-              {"RECORD", TokenType::RECORD},   {"THEN", TokenType::THEN},
-              {"TYPE", TokenType::TYPE},       {"VAR", TokenType::VAR},
-              {"WHILE", TokenType::WHILE},     {"TRUE", TokenType::TRUE},
-              {"FALSE", TokenType::FALSE},     {"NIL", TokenType::NIL},
-              {"FOR", TokenType::FOR},         {"RETURN", TokenType::RETURN},
-              {"REPEAT", TokenType::REPEAT},   {"CASE", TokenType::CASE},
-              {"UNTIL", TokenType::UNTIL},     {"IMPORT", TokenType::IMPORT},
-              {"POINTER", TokenType::POINTER}, {"IN", TokenType::IN},
-              {"IS", TokenType::IS},           {"TO", TokenType::TO}};
-        const auto& iter = lexToKeywordType.find(lex);
-        if (iter == lexToKeywordType.end()) {
+    constexpr TokenType Token::keywordTypeFromLexeme(const std::string& lex) {
+        const auto iter = std::lower_bound(
+              KEYWORD_TYPES.begin(), KEYWORD_TYPES.end(), std::string_view{lex},
+              [](const auto& keywordType, const std::string_view lexeme) {
+                  return keywordType.first < lexeme;
+              });
+        if (iter == KEYWORD_TYPES.end() || iter->first != lex) {
             return TokenType::IDENT;
         }
         return iter->second;
     }
 
-    TokenType Token::typeFromIdentifierLexeme(const bool lowerCaseKeywords,
-                                              const std::string& idLex) {
+    constexpr TokenType Token::typeFromIdentifierLexeme(const bool lowerCaseKeywords,
+                                                        const std::string& idLex) {
         if (!lowerCaseKeywords) {
             // The scanner is supporting the standard casing of Oberon keywords: the lexeme
             // must be provided in all upper case to be recognized as a keyword.
@@ -199,19 +217,15 @@ namespace obc {
         // uppercase form to the keyword matcher.
         std::string upperLex(idLex.size(), ' ');
         for (std::size_t i = 0; i < idLex.size(); i++) {
-            if (idLex.at(i) == std::tolower(idLex.at(i))) {
-                upperLex.at(i) = static_cast<char>(std::toupper(idLex.at(i)));
+            if (!isUpperLetter(idLex.at(i))) {
+                upperLex.at(i) = toUpperLetter(idLex.at(i));
             } else {
-                break;
+                // The lexeme is not all lowercase - there's no chance for it to be a
+                // lowercase keyword; it is assumed to be an identifier.
+                return TokenType::IDENT;
             }
         }
-        if (upperLex.size() == idLex.size()) {
-            // A completed uppercase form means the lexeme is all lowercase
-            return keywordTypeFromLexeme(upperLex);
-        }
-        // If this point is reached, it means that the lexeme was not all lowercase. There's no
-        // chance for it to be a lowercase keyword; it is assumed to be an identifier.
-        return TokenType::IDENT;
+        return keywordTypeFromLexeme(upperLex);
     }
 
     export std::ostream& operator<<(std::ostream& out, const Token& token);
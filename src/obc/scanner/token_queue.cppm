@@ -0,0 +1,175 @@
+module;
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+export module obc.scanner:token_queue;
+
+import :token;
+
+namespace obc {
+
+    // Number of tokens a pipelined scan groups in a batch before handing it over to the
+    // consumer side of a TokenQueue.
+    export constexpr std::size_t TOKEN_BATCH_SIZE{256U};
+
+    export using TokenBatch = std::vector<Token>;
+
+    /**
+     * @brief Bounded, lock-free, single-producer/single-consumer queue of token batches.
+     *
+     * Connects a scanner running on one thread (the producer) to a parser running on another
+     * thread (the consumer), allowing both phases to overlap. Batches are swapped in and out
+     * of the queue slots, so the vectors released by the consumer are handed back to the
+     * producer with their capacity preserved.
+     *
+     * Pushing and popping are lock-free. A side that finds the queue full (or empty) spins for
+     * a short while and then blocks on an atomic wait, so a slow peer doesn't keep it busy.
+     *
+     * @attention Exactly one thread may call the producer methods (push and close) and exactly
+     * one thread may call the consumer methods (tryPop and pop).
+     */
+    export class TokenQueue {
+       public:
+        // Maximum number of batches that can be in the queue at any given time. Must be a
+        // power of two.
+        static constexpr std::size_t CAPACITY{64U};
+
+        /**
+         * @brief Tries to hand a batch of tokens over to the consumer.
+         *
+         * @param batch the batch to be queued. On success, it is left empty.
+         * @return true if the batch has been queued; false if the queue is full.
+         */
+        bool tryPush(TokenBatch& batch) {
+            const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_head.load(std::memory_order_acquire) == CAPACITY) {
+                return false;
+            }
+            TokenBatch& slot = m_slots.at(tail & (CAPACITY - 1));
+            slot.swap(batch);
+            batch.clear();
+            m_tail.store(tail + 1, std::memory_order_release);
+            signal(m_pushSignal);
+            return true;
+        }
+
+        /**
+         * @brief Hands a batch of tokens over to the consumer, waiting for a free slot if the
+         * queue is full.
+         *
+         * @param batch the batch to be queued. It is left empty.
+         */
+        void push(TokenBatch& batch) {
+            for (std::size_t spins = 0; !tryPush(batch); spins++) {
+                if (spins < SPIN_LIMIT) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                // The signal is read before checking the queue again - a pop after the check
+                // changes the signal, so the wait can't miss it.
+                const std::uint32_t popSignal = m_popSignal.load(std::memory_order_acquire);
+                if (tryPush(batch)) {
+                    return;
+                }
+                m_popSignal.wait(popSignal, std::memory_order_acquire);
+            }
+        }
+
+        /**
+         * @brief Signals the consumer that no more batches will be pushed.
+         */
+        void close() {
+            m_closed.store(true, std::memory_order_release);
+            signal(m_pushSignal);
+        }
+
+        /**
+         * @brief Tries to take the oldest batch of tokens out of the queue.
+         *
+         * @param batch receives the batch taken out of the queue. Its previous contents are
+         * discarded.
+         * @return true if a batch has been taken; false if the queue is empty.
+         */
+        bool tryPop(TokenBatch& batch) {
+            const std::size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail.load(std::memory_order_acquire)) {
+                return false;
+            }
+            batch.clear();
+            TokenBatch& slot = m_slots.at(head & (CAPACITY - 1));
+            slot.swap(batch);
+            m_head.store(head + 1, std::memory_order_release);
+            signal(m_popSignal);
+            return true;
+        }
+
+        /**
+         * @brief Takes the oldest batch of tokens out of the queue, waiting for the producer if
+         * the queue is empty.
+         *
+         * @param batch receives the batch taken out of the queue. Its previous contents are
+         * discarded.
+         * @return true if a batch has been taken; false if the queue has been closed and all
+         * its batches have already been taken.
+         */
+        bool pop(TokenBatch& batch) {
+            for (std::size_t spins = 0; !tryPop(batch); spins++) {
+                if (m_closed.load(std::memory_order_acquire)) {
+                    // The producer may have pushed its last batch right before closing.
+                    return tryPop(batch);
+                }
+                if (spins < SPIN_LIMIT) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                // The signal is read before checking the queue again - a push (or the close)
+                // after the check changes the signal, so the wait can't miss it.
+                const std::uint32_t pushSignal = m_pushSignal.load(std::memory_order_acquire);
+                if (tryPop(batch)) {
+                    return true;
+                }
+                if (m_closed.load(std::memory_order_acquire)) {
+                    return tryPop(batch);
+                }
+                m_pushSignal.wait(pushSignal, std::memory_order_acquire);
+            }
+            return true;
+        }
+
+       private:
+        // Size of the cache line used to keep the producer and consumer indexes apart.
+        static constexpr std::size_t CACHE_LINE_SIZE{64U};
+        // Number of times a side retries (yielding in between) before blocking on the signal
+        // of the other side.
+        static constexpr std::size_t SPIN_LIMIT{64U};
+
+        /**
+         * @brief Signals a change made by one side to the other side, waking it up if it is
+         * blocked waiting for the change.
+         */
+        static void signal(std::atomic<std::uint32_t>& sideSignal) {
+            sideSignal.fetch_add(1, std::memory_order_release);
+            sideSignal.notify_one();
+        }
+
+        static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two.");
+
+        std::array<TokenBatch, CAPACITY> m_slots{};
+        // Index of the next slot to be read - only advanced by the consumer.
+        alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_head{0};
+        // Index of the next slot to be written - only advanced by the producer.
+        alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_tail{0};
+        alignas(CACHE_LINE_SIZE) std::atomic<bool> m_closed{false};
+        // Changed by every push (and by the close) - waited on by a consumer facing an empty
+        // queue.
+        alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> m_pushSignal{0};
+        // Changed by every pop - waited on by a producer facing a full queue.
+        alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> m_popSignal{0};
+    };
+
+} // namespace obc
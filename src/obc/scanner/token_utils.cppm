@@ -0,0 +1,103 @@
+module;
+
+#include <string>
+
+export module obc.scanner:token_utils;
+
+namespace obc {
+
+    // The helpers below only deal with ASCII characters - just like the Oberon grammar does -
+    // and are used instead of their <cctype> counterparts because they must be usable in
+    // constant evaluation.
+
+    /**
+    * @brief Returns whether a given char is a base 10 digit or not.
+    *
+    * @param chr the character to be verified
+    * @return true if chr is a base 10 digit; false otherwise.
+    */
+    constexpr bool isDigit(const char chr) {
+        return chr >= '0' && chr <= '9';
+    }
+
+    /**
+    * @brief Returns whether a given char is an (ASCII) letter or not.
+    *
+    * @param chr the character to be verified
+    * @return true if chr is a letter; false otherwise.
+    */
+    constexpr bool isLetter(const char chr) {
+        return (chr >= 'a' && chr <= 'z') || (chr >= 'A' && chr <= 'Z');
+    }
+
+    /**
+    * @brief Returns whether a given char is an uppercase (ASCII) letter or not.
+    *
+    * @param chr the character to be verified
+    * @return true if chr is an uppercase letter; false otherwise.
+    */
+    constexpr bool isUpperLetter(const char chr) {
+        return chr >= 'A' && chr <= 'Z';
+    }
+
+    /**
+    * @brief Returns the uppercase form of a given char.
+    *
+    * @param chr the character to be converted
+    * @return the uppercase form of chr if it is a lowercase letter; chr otherwise.
+    */
+    constexpr char toUpperLetter(const char chr) {
+        if (chr >= 'a' && chr <= 'z') {
+            return static_cast<char>(chr - 'a' + 'A');
+        }
+        return chr;
+    }
+
+    /**
+    * @brief Returns whether a given char is a hexadecimal digit or not.
+    *
+    * @note Oberon's grammar specifies only uppercase 'A' to 'F' as valid hexadecimal
+    * digits. We stick to the specification in here.
+    *
+    * @param chr the character to be verified
+    * @return true if chr is a hexadecimal digit; false otherwise.
+    */
+    constexpr bool isHexDigit(const char chr) {
+        return isDigit(chr) || chr == 'A' || chr == 'B' || chr == 'D' || chr == 'E' ||
+               chr == 'F';
+    }
+
+    /**
+    * @brief Returns whether a given string is composed exclusively of base 10 digits.
+    *
+    * @param str the string to be verified
+    * @return true if all characters in the string are base 10 digits; false otherwise.
+    */
+    constexpr bool allBase10Digits(const std::string& str) {
+        for (const char chr : str) {
+            if (!isDigit(chr)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+    * @brief Returns the value of a sequence of hexadecimal digits.
+    *
+    * @attention The caller must make sure that all the characters in the string are
+    * hexadecimal digits (as checked by isHexDigit) and that the value fits in an int.
+    *
+    * @param hexDigits the hexadecimal digits, most significant first.
+    * @return the value of the hexadecimal digits.
+    */
+    constexpr int hexValue(const std::string& hexDigits) {
+        constexpr int hexBase = 16;
+        int value = 0;
+        for (const char chr : hexDigits) {
+            value = value * hexBase + (isDigit(chr) ? chr - '0' : chr - 'A' + 10);
+        }
+        return value;
+    }
+
+} // namespace obc
@@ -0,0 +1,250 @@
+module;
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+export module obc.trace;
+
+namespace obc {
+
+    // An event of a trace - either the begin or the end of a phase run by a thread.
+    struct TraceEvent {
+        // Name of the phase - always a string literal.
+        const char* phase;
+        // Chrome trace-event type of the event: 'B' for begin, 'E' for end.
+        char type;
+        // Time of the event, in nanoseconds since tracing was first enabled.
+        std::int64_t timestampNs;
+        // Id, in the buffer of the thread, of the source module being processed by the thread
+        // when the phase began (begin events only). -1 for no module.
+        int moduleId{-1};
+    };
+
+    /**
+     * The events recorded by a single thread. Only its owner thread ever appends to a buffer,
+     * so recording an event takes no lock. Buffers are linked together as they are created and
+     * are never freed - their events must outlive the threads that recorded them.
+     */
+    struct ThreadTraceBuffer {
+        // Sequential id of the thread (starting at 1), in the order threads first recorded an
+        // event.
+        int threadId;
+        std::vector<TraceEvent> events;
+        // Names of the modules the thread has worked on, indexed by their ids. Each name is
+        // kept once, so events only carry the id of their module. A deque keeps the names
+        // in place as it grows - the keys of moduleIds view them.
+        std::deque<std::string> moduleNames;
+        std::unordered_map<std::string_view, int> moduleIds;
+        // Id of the module set by the innermost TraceModule alive in the thread - -1 if
+        // there's none.
+        int currModuleId{-1};
+        ThreadTraceBuffer* next{nullptr};
+
+        /**
+         * @brief Returns the id of a module name, adding the name to the buffer on its first
+         * use.
+         */
+        int moduleIdOf(const std::string_view module) {
+            if (const auto iter = moduleIds.find(module); iter != moduleIds.end()) {
+                return iter->second;
+            }
+            const int moduleId = static_cast<int>(moduleNames.size());
+            moduleIds.emplace(moduleNames.emplace_back(module), moduleId);
+            return moduleId;
+        }
+    };
+
+    constinit std::atomic<bool> tracingOn{false};
+    // Start of the trace, as a steady_clock time since its epoch - 0 until tracing is first
+    // enabled.
+    constinit std::atomic<std::int64_t> traceEpochNs{0};
+    // Head of the (push-only) list of all the thread buffers created so far.
+    constinit std::atomic<ThreadTraceBuffer*> traceBuffers{nullptr};
+    constinit std::atomic<int> nextTraceThreadId{1};
+
+    std::int64_t steadyNowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now().time_since_epoch())
+              .count();
+    }
+
+    /**
+     * @brief Returns the trace buffer of the calling thread, creating (and linking) it on the
+     * first call from the thread.
+     */
+    ThreadTraceBuffer& threadTraceBuffer() {
+        thread_local ThreadTraceBuffer* const buffer = [] {
+            // NOLINTNEXTLINE(*-owning-memory) - buffers are never freed, by design.
+            auto* newBuffer = new ThreadTraceBuffer{
+                  .threadId = nextTraceThreadId.fetch_add(1, std::memory_order_relaxed)};
+            newBuffer->next = traceBuffers.load(std::memory_order_relaxed);
+            while (!traceBuffers.compare_exchange_weak(newBuffer->next, newBuffer,
+                                                       std::memory_order_release,
+                                                       std::memory_order_relaxed)) {
+            }
+            return newBuffer;
+        }();
+        return *buffer;
+    }
+
+    /**
+     * @brief Writes a string to an output stream as a JSON string literal.
+     */
+    void writeJsonString(std::ostream& ostream, const std::string_view str) {
+        constexpr unsigned char firstPrintable = 0x20U;
+        ostream << '"';
+        for (const char chr : str) {
+            if (chr == '"' || chr == '\\') {
+                ostream << '\\' << chr;
+            } else if (static_cast<unsigned char>(chr) < firstPrintable) {
+                ostream << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                        << static_cast<int>(chr) << std::dec << std::setfill(' ');
+            } else {
+                ostream << chr;
+            }
+        }
+        ostream << '"';
+    }
+
+    /**
+     * @brief Turns the recording of trace events on or off.
+     *
+     * Turning it on for the first time starts the clock of the trace - the timestamps of the
+     * events are relative to that moment. The clock isn't restarted when tracing is turned on
+     * again, as the events recorded before are kept. While it is off, trace scopes cost a
+     * single atomic load.
+     */
+    export void setTracingEnabled(const bool enabled) {
+        if (enabled) {
+            std::int64_t unsetEpoch = 0;
+            traceEpochNs.compare_exchange_strong(unsetEpoch, steadyNowNs(),
+                                                 std::memory_order_relaxed);
+        }
+        tracingOn.store(enabled, std::memory_order_release);
+    }
+
+    export bool tracingEnabled() {
+        return tracingOn.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Sets the source module the calling thread is working on, for as long as the
+     * TraceModule is alive. The phases traced in the meantime are attributed to the module.
+     */
+    export class TraceModule {
+       public:
+        explicit TraceModule(const std::string_view module) {
+            if (tracingEnabled()) {
+                m_buffer = &threadTraceBuffer();
+                m_prevModuleId =
+                      std::exchange(m_buffer->currModuleId, m_buffer->moduleIdOf(module));
+            }
+        }
+
+        ~TraceModule() {
+            if (m_buffer != nullptr) {
+                m_buffer->currModuleId = m_prevModuleId;
+            }
+        }
+
+        TraceModule(const TraceModule&) = delete;
+        TraceModule& operator=(const TraceModule&) = delete;
+        TraceModule(TraceModule&&) = delete;
+        TraceModule& operator=(TraceModule&&) = delete;
+
+       private:
+        ThreadTraceBuffer* m_buffer{nullptr};
+        int m_prevModuleId{-1};
+    };
+
+    /**
+     * @brief Records the begin (at its construction) and the end (at its destruction) of a
+     * phase run by the calling thread - if tracing is enabled when the phase begins.
+     */
+    export class TraceScope {
+       public:
+        /**
+         * @param phase the name of the phase - e.g., "scan". Must be a string literal (or
+         * otherwise outlive the trace).
+         */
+        explicit TraceScope(const char* phase) : m_phase{phase} {
+            if (tracingEnabled()) {
+                m_buffer = &threadTraceBuffer();
+                m_buffer->events.emplace_back(TraceEvent{.phase = m_phase,
+                                                         .type = 'B',
+                                                         .timestampNs = traceNowNs(),
+                                                         .moduleId = m_buffer->currModuleId});
+            }
+        }
+
+        ~TraceScope() {
+            if (m_buffer != nullptr) {
+                m_buffer->events.emplace_back(
+                      TraceEvent{.phase = m_phase, .type = 'E', .timestampNs = traceNowNs()});
+            }
+        }
+
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+        TraceScope(TraceScope&&) = delete;
+        TraceScope& operator=(TraceScope&&) = delete;
+
+       private:
+        static std::int64_t traceNowNs() {
+            return steadyNowNs() - traceEpochNs.load(std::memory_order_relaxed);
+        }
+
+        const char* m_phase;
+        // Buffer the begin event has been recorded to - null if tracing was disabled then.
+        ThreadTraceBuffer* m_buffer{nullptr};
+    };
+
+    /**
+     * @brief Writes all the events recorded so far, by all the threads, to an output stream
+     * in the Chrome trace-event JSON format - as loaded by chrome://tracing or Perfetto.
+     *
+     * @attention The threads that recorded the events must not be recording any more of them
+     * (e.g., they must have been joined) while the trace is written.
+     *
+     * @param ostream the stream the trace is written to.
+     */
+    export void writeChromeTrace(std::ostream& ostream) {
+        constexpr double nsPerUs = 1000.0;
+        const std::ios_base::fmtflags prevFlags = ostream.flags();
+        const std::streamsize prevPrecision = ostream.precision();
+        ostream << std::fixed << std::setprecision(3) << R"({"traceEvents":[)";
+        bool firstEvent = true;
+        for (const ThreadTraceBuffer* buffer = traceBuffers.load(std::memory_order_acquire);
+             buffer != nullptr; buffer = buffer->next) {
+            for (const TraceEvent& event : buffer->events) {
+                ostream << (firstEvent ? "\n" : ",\n") << R"({"name":)";
+                writeJsonString(ostream, event.phase);
+                ostream << R"(,"cat":"obc","ph":")" << event.type
+                        << R"(","ts":)" << static_cast<double>(event.timestampNs) / nsPerUs
+                        << R"(,"pid":1,"tid":)" << buffer->threadId;
+                if (event.moduleId >= 0) {
+                    ostream << R"(,"args":{"module":)";
+                    const auto moduleIdx = static_cast<std::size_t>(event.moduleId);
+                    writeJsonString(ostream, buffer->moduleNames.at(moduleIdx));
+                    ostream << '}';
+                }
+                ostream << '}';
+                firstEvent = false;
+            }
+        }
+        ostream << "\n]," << R"("displayTimeUnit":"ms"})" << '\n';
+        ostream.flags(prevFlags);
+        ostream.precision(prevPrecision);
+    }
+
+} // namespace obc
@@ -1,11 +1,71 @@
 #include <gtest/gtest.h>
 
+#include <chrono>
 #include <filesystem>
+#include <fstream>
+#include <memory_resource>
+#include <sstream>
+#include <string_view>
+#include <thread>
 
+import obc.alloc_stats;
+import obc.error_info;
 import obc.scanner;
+import obc.trace;
 
 using namespace obc;
 
+namespace {
+
+#if defined(_MSC_VER) && defined(_ITERATOR_DEBUG_LEVEL) && _ITERATOR_DEBUG_LEVEL > 0
+    // With its checked iterators on, the Microsoft standard library allocates a proxy for
+    // every string and container - the number of allocations of a scan depends on it.
+    constexpr bool EXACT_ALLOC_COUNTS{false};
+#else
+    constexpr bool EXACT_ALLOC_COUNTS{true};
+#endif
+
+    // Returns the path of one of the sample sources used by the tests.
+    std::string samplePath(const std::string& name) {
+        return std::filesystem::path(__FILE__)
+              .parent_path()
+              .append("oberon_src")
+              .append(name)
+              .string();
+    }
+
+    // Returns the contents of one of the sample sources used by the tests.
+    std::string readSample(const std::string& name) {
+        std::ostringstream srcStream;
+        srcStream << std::ifstream(samplePath(name)).rdbuf();
+        return srcStream.str();
+    }
+
+    // Verifies that the results of a scan have the same tokens and errors as the expected
+    // ones.
+    void expectSameResults(const ScanResults& actual, const ScanResults& expected) {
+        ASSERT_EQ(actual.tokens.size(), expected.tokens.size());
+        for (std::size_t i = 0; i < expected.tokens.size(); i++) {
+            const Token& actualToken = actual.tokens.at(i);
+            const Token& expectToken = expected.tokens.at(i);
+            EXPECT_EQ(actualToken.type, expectToken.type) << "token " << i;
+            EXPECT_EQ(actualToken.lexeme, expectToken.lexeme) << "token " << i;
+            EXPECT_EQ(actualToken.line, expectToken.line) << "token " << i;
+        }
+        ASSERT_EQ(actual.errors.size(), expected.errors.size());
+        for (std::size_t i = 0; i < expected.errors.size(); i++) {
+            const ErrorInfo& actualError = actual.errors.at(i);
+            const ErrorInfo& expectError = expected.errors.at(i);
+            EXPECT_EQ(actualError.code, expectError.code) << "error " << i;
+            EXPECT_EQ(actualError.line, expectError.line) << "error " << i;
+            EXPECT_EQ(actualError.column, expectError.column) << "error " << i;
+            EXPECT_EQ(actualError.offset, expectError.offset) << "error " << i;
+            EXPECT_EQ(actualError.msg(), expectError.msg()) << "error " << i;
+        }
+    }
+
+} // namespace
+
 TEST(ScannerTests, TestEmptyFile) { // NOLINT(*-throwing-static-initialization, *-owning-memory)
     // An empty file must have the EOM token and no errors.
     const auto [tokens, errors] = Scanner::scan("");
@@ -14,6 +74,20 @@ TEST(ScannerTests, TestEmptyFile) { // NOLINT(*-throwing-static-initialization,
     EXPECT_EQ(errors.size(), 0);
 }
 
+TEST(ScannerTests, TestMissingFile) { // NOLINT(*-throwing-static-initialization, *-owning-memory)
+    // A source file error isn't located and its record doesn't keep the path of the file -
+    // the path is only mentioned when the caller renders the message with it.
+    const std::string srcPath = samplePath("NoSuchModule.Mod");
+    const auto [tokens, errors] = Scanner::scanSrcFile(srcPath);
+    EXPECT_EQ(tokens.size(), 0);
+    ASSERT_EQ(errors.size(), 1);
+    EXPECT_EQ(errors.at(0).code, ErrorCode::FILE_NOT_AVAILABLE);
+    EXPECT_EQ(errors.at(0).line, -1);
+    EXPECT_EQ(errors.at(0).msg(), "Source file not found or not available for reading.");
+    EXPECT_EQ(errors.at(0).msg(srcPath),
+              "File '" + srcPath + "' not found or not available for reading.");
+}
+
 TEST(ScannerTests, TestLowerCaseKeywords) { // NOLINT(*-throwing-static-initialization, *-owning-memory, *-function-cognitive-complexity)
     const std::string lowerCaseSrc{
           R"(
@@ -134,7 +208,7 @@ comment and should be rejected.
     ASSERT_EQ(errors.size(), 1);
     EXPECT_EQ(errors.at(0).line, 6);
     EXPECT_EQ(errors.at(0).column, 1);
-    EXPECT_EQ(errors.at(0).msg, unfinishedCommentMsg);
+    EXPECT_EQ(errors.at(0).msg(), unfinishedCommentMsg);
 }
 
 TEST(ScannerTests, TestModuleWithInvalidSymbol) { // NOLINT(*-throwing-static-initialization, *-owning-memory, *-function-cognitive-complexity)
@@ -171,7 +245,7 @@ END.
     // is already line 2 in the source - that's the reason for the line with the
     // invalid symbol being line 8.
     EXPECT_EQ(errors.at(0).line, 8);
-    EXPECT_EQ(errors.at(0).msg, std::string{"Unexpected character, '?' found."});
+    EXPECT_EQ(errors.at(0).msg(), std::string{"Unexpected character, '?' found."});
 }
 
 TEST(ScannerTests, TestModuleWithStringLiteral) { // NOLINT(*-throwing-static-initialization, *-owning-memory, *-function-cognitive-complexity)
@@ -239,16 +313,451 @@ TEST(ScannerTests, TestModuleWithNumericLiterals) { // NOLINT(*-throwing-static-
     ASSERT_EQ(errors.size(), 4);
     EXPECT_EQ(errors.at(0).line, 3);
     EXPECT_EQ(errors.at(0).column, 41);
-    EXPECT_EQ(errors.at(0).msg, "Hexadecimal number must be terminated with an 'H'.");
+    EXPECT_EQ(errors.at(0).msg(), "Hexadecimal number must be terminated with an 'H'.");
     EXPECT_EQ(errors.at(1).line, 4);
     EXPECT_EQ(errors.at(1).column, 45);
-    EXPECT_EQ(errors.at(1).msg,
+    EXPECT_EQ(errors.at(1).msg(),
               "Real number scale factor must start with an 'E' followed by either a '+' or '-' "
               "signal.");
     EXPECT_EQ(errors.at(2).line, 8);
     EXPECT_EQ(errors.at(2).column, 31);
-    EXPECT_EQ(errors.at(2).msg, "Hexadecimal number must be terminated with an 'H'.");
+    EXPECT_EQ(errors.at(2).msg(), "Hexadecimal number must be terminated with an 'H'.");
     EXPECT_EQ(errors.at(3).line, 12);
     EXPECT_EQ(errors.at(3).column, 41);
-    EXPECT_EQ(errors.at(3).msg, "Real numbers must use only digits between 0 and 9.");
+    EXPECT_EQ(errors.at(3).msg(), "Real numbers must use only digits between 0 and 9.");
+}
+
+TEST(ScannerTests, TestPipelinedScan) { // NOLINT(*-throwing-static-initialization, *-owning-memory, *-function-cognitive-complexity)
+    // A pipelined scan must hand over the same tokens, in the same order, and report the
+    // same errors as a sequential scan of the same source.
+    const std::string sample{readSample("Samples.Mod")};
+    // The source is repeated to make sure the tokens are handed over in several batches.
+    std::string src;
+    constexpr int srcRepeats = 50;
+    for (int i = 0; i < srcRepeats; i++) {
+        src += sample + "\n?\n";
+    }
+
+    const ScanResults expected = Scanner::scan(src);
+    ASSERT_GT(expected.tokens.size(), TOKEN_BATCH_SIZE * 2);
+    ASSERT_EQ(expected.errors.size(), srcRepeats);
+
+    TokenQueue tokenQueue;
+    ScanResults pipelinedRes;
+    std::thread scanThread{[&] { pipelinedRes = Scanner::scan(src, tokenQueue); }};
+    std::vector<Token> tokens;
+    TokenBatch batch;
+    while (tokenQueue.pop(batch)) {
+        tokens.insert(tokens.end(), batch.begin(), batch.end());
+    }
+    scanThread.join();
+
+    EXPECT_TRUE(pipelinedRes.tokens.empty());
+    expectSameResults(ScanResults{.tokens = std::move(tokens), .errors = pipelinedRes.errors},
+                      expected);
+}
+
+TEST(ScannerTests, TestTokenQueueBlocking) { // NOLINT(*-throwing-static-initialization, *-owning-memory, *-function-cognitive-complexity)
+    // Each side of a queue must be woken up by the other side once it blocks - the consumer by
+    // a push or by the close, the producer by a pop.
+    constexpr auto peerDelay = std::chrono::milliseconds(50);
+    TokenQueue tokenQueue;
+    std::size_t poppedBatches = 0;
+    std::thread consumer{[&] {
+        TokenBatch batch;
+        while (tokenQueue.pop(batch)) {
+            poppedBatches++;
+        }
+    }};
+    std::this_thread::sleep_for(peerDelay);
+    TokenBatch batch;
+    for (std::size_t i = 0; i < TokenQueue::CAPACITY * 4; i++) {
+        batch.emplace_back(Token{.type = TokenType::IDENT, .lexeme = "i", .line = 1});
+        tokenQueue.push(batch);
+    }
+    std::this_thread::sleep_for(peerDelay);
+    tokenQueue.close();
+    consumer.join();
+    EXPECT_EQ(poppedBatches, TokenQueue::CAPACITY * 4);
+
+    // A full queue blocks its producer until the consumer starts taking batches out of it.
+    TokenQueue fullQueue;
+    std::thread producer{[&fullQueue] {
+        TokenBatch batch;
+        for (std::size_t i = 0; i < TokenQueue::CAPACITY * 2; i++) {
+            batch.emplace_back(Token{.type = TokenType::IDENT, .lexeme = "i", .line = 1});
+            fullQueue.push(batch);
+        }
+        fullQueue.close();
+    }};
+    std::this_thread::sleep_for(peerDelay);
+    std::size_t poppedFromFull = 0;
+    while (fullQueue.pop(batch)) {
+        poppedFromFull++;
+    }
+    producer.join();
+    EXPECT_EQ(poppedFromFull, TokenQueue::CAPACITY * 2);
+}
+
+TEST(ScannerTests, TestScanSession) { // NOLINT(*-throwing-static-initialization, *-owning-memory, *-function-cognitive-complexity)
+    // A scan session must produce the same results as independent scan operations, no matter
+    // how many sources it has already scanned.
+    const std::vector<std::string> srcs{
+          "MODULE First; BEGIN WriteLn(\"First\") END First.",
+          "MODULE Second;\n  VAR i: INTEGER?;\nEND Second.",
+          "",
+          // A tab after an error must still cause the column of the error to be ignored.
+          "MODULE Third; ?\n(*\tcomment with a tab *)\nEND Third."};
+
+    ScanSession session;
+    const std::vector<ScanResults> allResults = session.scanMany(srcs);
+    ASSERT_EQ(allResults.size(), srcs.size());
+    for (std::size_t i = 0; i < srcs.size(); i++) {
+        const ScanResults expected = Scanner::scan(srcs.at(i));
+        expectSameResults(allResults.at(i), expected);
+        expectSameResults(session.scan(srcs.at(i)), expected);
+    }
+
+    EXPECT_EQ(allResults.at(1).errors.size(), 1);
+    EXPECT_EQ(allResults.at(1).errors.at(0).column, 18);
+
+    // The results handed out by a session are sized to their contents - a large source
+    // scanned first doesn't inflate the results of the smaller ones that follow it.
+    std::vector<std::string> mixedSrcs{readSample("Samples.Mod")};
+    mixedSrcs.insert(mixedSrcs.end(), srcs.begin(), srcs.end());
+    const std::vector<ScanResults> mixedResults = session.scanMany(mixedSrcs);
+    ASSERT_EQ(mixedResults.size(), mixedSrcs.size());
+    EXPECT_GT(mixedResults.at(0).tokens.size(), mixedResults.at(1).tokens.size() * 10);
+    for (const ScanResults& res : mixedResults) {
+        EXPECT_EQ(res.tokens.capacity(), res.tokens.size());
+        EXPECT_EQ(res.errors.capacity(), res.errors.size());
+    }
+    ASSERT_EQ(allResults.at(3).errors.size(), 1);
+    EXPECT_EQ(allResults.at(3).errors.at(0).line, 1);
+    EXPECT_EQ(allResults.at(3).errors.at(0).column, -1);
+}
+
+TEST(ScannerTests, TestMaxErrors) { // NOLINT(*-throwing-static-initialization, *-owning-memory, *-function-cognitive-complexity)
+    // A scan must stop as soon as the maximum number of errors is reached, signaling the
+    // early stop with a final error.
+    const std::string errorsSrc{"MODULE Errors; ? ? ?\n? ?\nEND Errors."};
+
+    auto [tokens, errors] = Scanner::scan(errorsSrc);
+    ASSERT_EQ(errors.size(), 5);
+    EXPECT_EQ(tokens.size(), 7);
+    for (const ErrorInfo& error : errors) {
+        EXPECT_EQ(error.code, ErrorCode::UNEXPECTED_CHAR);
+        EXPECT_EQ(error.arg, '?');
+        EXPECT_EQ(errorsSrc.at(error.offset), '?');
+    }
+
+    // The offset of an error found in a lexeme is the offset of the start of the lexeme.
+    const std::string lexemesSrc{"x := 12AB; y := 1.5E*2; s := \"open\n(* open"};
+    const auto [lexTokens, lexErrors] = Scanner::scan(lexemesSrc);
+    ASSERT_EQ(lexErrors.size(), 4);
+    EXPECT_EQ(lexErrors.at(0).code, ErrorCode::UNTERMINATED_HEX_INTEGER);
+    EXPECT_EQ(lexErrors.at(0).offset, lexemesSrc.find("12AB"));
+    EXPECT_EQ(lexErrors.at(1).code, ErrorCode::INVALID_SCALE_FACTOR_SIGN);
+    EXPECT_EQ(lexErrors.at(1).offset, lexemesSrc.find("1.5E"));
+    EXPECT_EQ(lexErrors.at(2).code, ErrorCode::UNTERMINATED_STRING);
+    EXPECT_EQ(lexErrors.at(2).offset, lexemesSrc.find('"'));
+    EXPECT_EQ(lexErrors.at(3).code, ErrorCode::UNFINISHED_COMMENT);
+    EXPECT_EQ(lexErrors.at(3).offset, lexemesSrc.find("(*"));
+
+    constexpr std::size_t maxErrors = 4;
+    const auto [limTokens, limErrors] = Scanner::scan(errorsSrc, false, maxErrors);
+    ASSERT_EQ(limErrors.size(), maxErrors + 1);
+    EXPECT_EQ(limErrors.at(3).line, 2);
+    EXPECT_EQ(limErrors.at(4).code, ErrorCode::TOO_MANY_ERRORS);
+    EXPECT_EQ(limErrors.at(4).msg(), "Too many errors (limit is 4); scan stopped.");
+    // The tokens found before the stop are kept - and the End-of-Module is still there.
+    ASSERT_EQ(limTokens.size(), 4);
+    EXPECT_EQ(limTokens.at(limTokens.size() - 1).type, TokenType::EOM);
+
+    // The limit also stops a scan in the middle of a comment or a string full of invalid
+    // bytes - without collecting more errors than it keeps.
+    const std::string invalidBytes(100000, '\xFF');
+    for (const std::string& invalidSrc :
+         {"(* " + invalidBytes + " *)", "s := \"" + invalidBytes + "\""}) {
+        const ScanResults expected = Scanner::scan(invalidSrc, false, maxErrors);
+        ASSERT_EQ(expected.errors.size(), maxErrors + 1);
+        EXPECT_EQ(expected.errors.at(0).code, ErrorCode::INVALID_ENCODING);
+        EXPECT_EQ(expected.errors.at(maxErrors).code, ErrorCode::TOO_MANY_ERRORS);
+        EXPECT_LT(expected.errors.capacity(), maxErrors * 4);
+        std::istringstream srcInput{invalidSrc};
+        expectSameResults(Scanner::scanStream(srcInput, false, maxErrors), expected);
+    }
+}
+
+TEST(ScannerTests, TestStreamScan) { // NOLINT(*-throwing-static-initialization, *-owning-memory, *-function-cognitive-complexity)
+    // A streaming scan must find the same tokens and errors as a scan of the same source in
+    // memory - including the tokens, strings, comments and UTF-8 sequences that cross the
+    // boundaries of the window through which the stream is read.
+    const std::string sample{readSample("Samples.Mod")};
+    // The first window ends right in the middle of the '\xE2\x82\xAC' in the comment.
+    constexpr std::size_t firstWindowSize = 64 * 1024;
+    std::string src{"(* " + std::string(firstWindowSize - 4, '-') + "\xE2\x82\xAC *)\n"};
+    constexpr int srcRepeats = 200;
+    constexpr std::size_t longLexemeSize = 100000;
+    for (int i = 0; i < srcRepeats; i++) {
+        // UTF-8 in comments and strings, a Latin-1 byte and a character outside of both.
+        src += sample + "\n?\n";
+        src += "s := \"a\xC3\xA7\xC3\xA3o\" (* caf\xE9 ol\xC3\xA1 *) \xE2\x82\xAC\n";
+        if (i % 50 == 0) {
+            // Comments and strings longer than the window are bound to cross its boundaries.
+            src += "(*" + std::string(longLexemeSize, '*') + "*)\n";
+            src += "\"" + std::string(longLexemeSize, 'S') + "\"\n";
+        }
+    }
+
+    // A sequence cut short by the end of the stream is made up of invalid bytes.
+    src += "(* \xF0\x9F\x98";
+
+    const ScanResults expected = Scanner::scan(src);
+    ASSERT_EQ(expected.errors.size(), srcRepeats * 3 + 4);
+    std::istringstream srcInput{src};
+    expectSameResults(Scanner::scanStream(srcInput), expected);
+}
+
+TEST(ScannerTests, TestStreamScanMemory) { // NOLINT(*-throwing-static-initialization, *-owning-memory, *-function-cognitive-complexity)
+    // Streaming a source through a queue whose consumer discards the tokens must take a
+    // bounded amount of memory - the window and the batches in the queue - whatever the size
+    // of the source.
+    ASSERT_TRUE(globalAllocHooksActive());
+    constexpr std::size_t srcLines = 512 * 1024;
+    std::string src;
+    for (std::size_t i = 0; i < srcLines; i++) {
+        src += "x := 1;\n";
+    }
+    std::istringstream srcInput{src};
+
+    const AllocPhase streamPhase;
+    TokenQueue tokenQueue;
+    ScanResults streamRes;
+    std::thread scanThread{[&] { streamRes = Scanner::scanStream(srcInput, tokenQueue); }};
+    std::size_t tokensCount = 0;
+    TokenBatch batch;
+    while (tokenQueue.pop(batch)) {
+        tokensCount += batch.size();
+    }
+    scanThread.join();
+    const AllocStats streamStats = streamPhase.stats();
+
+    EXPECT_EQ(tokensCount, srcLines * 4 + 1);
+    EXPECT_TRUE(streamRes.errors.empty());
+    // Every slot of the queue may hold a full batch, besides the ones being filled in and
+    // read.
+    constexpr std::size_t batchesBytes =
+          (TokenQueue::CAPACITY + 2) * TOKEN_BATCH_SIZE * sizeof(Token);
+    EXPECT_LE(streamStats.peakLiveBytes, batchesBytes + 256 * 1024);
+    EXPECT_LT(streamStats.peakLiveBytes, src.size() / 2);
+}
+
+TEST(ScannerTests, TestSourceEncoding) { // NOLINT(*-throwing-static-initialization, *-owning-memory, *-function-cognitive-complexity)
+    // Invalid UTF-8 bytes are found anywhere in a source - including in its last, partial
+    // word - and a tab anywhere drops the columns of all the errors.
+    const auto [tabTokens, tabErrors] =
+          Scanner::scan("MODULE Encoding;\n\t(* caf\xC3\xA9 *)\n(* caf\xE9 *)\n\x80");
+    ASSERT_EQ(tabErrors.size(), 2);
+    EXPECT_EQ(tabErrors.at(0).code, ErrorCode::INVALID_ENCODING);
+    EXPECT_EQ(tabErrors.at(0).offset, 36);
+    EXPECT_EQ(tabErrors.at(0).line, 3);
+    EXPECT_EQ(tabErrors.at(1).code, ErrorCode::INVALID_ENCODING);
+    EXPECT_EQ(tabErrors.at(1).offset, 41);
+    EXPECT_EQ(tabErrors.at(1).line, 4);
+    EXPECT_EQ(tabErrors.at(1).arg, 0x80);
+    for (const ErrorInfo& error : tabErrors) {
+        EXPECT_EQ(error.column, -1);
+    }
+
+    // UTF-8 is accepted in comments and strings, where the columns are counted in characters.
+    const auto [tokens, errors] =
+          Scanner::scan("(* Ol\xC3\xA1, at\xC3\xA9 logo *)\ns := \"a\xC3\xA7\xC3\xA3o\" $");
+    ASSERT_EQ(tokens.size(), 4);
+    EXPECT_EQ(tokens.at(2).type, TokenType::STRING);
+    EXPECT_EQ(tokens.at(2).lexeme, "a\xC3\xA7\xC3\xA3o");
+    ASSERT_EQ(errors.size(), 1);
+    EXPECT_EQ(errors.at(0).code, ErrorCode::UNEXPECTED_CHAR);
+    EXPECT_EQ(errors.at(0).line, 2);
+    EXPECT_EQ(errors.at(0).column, 14);
+
+    // A non-ASCII character outside comments and strings is a single unexpected character.
+    const auto [utf8Tokens, utf8Errors] = Scanner::scan("x := \xE2\x82\xAC;");
+    ASSERT_EQ(utf8Errors.size(), 1);
+    EXPECT_EQ(utf8Errors.at(0).msg(), "Unexpected character, '\xE2\x82\xAC' found.");
+    EXPECT_EQ(utf8Errors.at(0).offset, 5);
+    EXPECT_EQ(utf8Tokens.at(2).type, TokenType::SEMICOLON);
+
+    // A non-ASCII character right after the 'E' (or the sign) of a scale factor isn't taken
+    // as part of it - the whole character is reported on its own.
+    const auto [scaleTokens, scaleErrors] =
+          Scanner::scan("x := 1.E\xE2\x82\xAC; y := 1.5E+\xC3\xA9;");
+    ASSERT_EQ(scaleErrors.size(), 4);
+    EXPECT_EQ(scaleErrors.at(0).code, ErrorCode::INVALID_SCALE_FACTOR_SIGN);
+    EXPECT_EQ(scaleErrors.at(0).offset, 5);
+    EXPECT_EQ(scaleErrors.at(1).code, ErrorCode::UNEXPECTED_CHAR);
+    EXPECT_EQ(scaleErrors.at(1).offset, 8);
+    EXPECT_EQ(scaleErrors.at(1).msg(), "Unexpected character, '\xE2\x82\xAC' found.");
+    EXPECT_EQ(scaleErrors.at(2).code, ErrorCode::MISSING_SCALE_FACTOR_DIGITS);
+    EXPECT_EQ(scaleErrors.at(2).offset, 18);
+    EXPECT_EQ(scaleErrors.at(3).code, ErrorCode::UNEXPECTED_CHAR);
+    EXPECT_EQ(scaleErrors.at(3).offset, 23);
+    EXPECT_EQ(scaleTokens.at(scaleTokens.size() - 2).type, TokenType::SEMICOLON);
+
+    // Bytes that are not valid UTF-8 - e.g., from a Latin-1 source - are pinpointed.
+    const auto [latin1Tokens, latin1Errors] = Scanner::scan("(* caf\xE9 *) s := \"\xE0\" \xFF");
+    ASSERT_EQ(latin1Errors.size(), 3);
+    for (const ErrorInfo& error : latin1Errors) {
+        EXPECT_EQ(error.code, ErrorCode::INVALID_ENCODING);
+    }
+    EXPECT_EQ(latin1Errors.at(0).offset, 6);
+    EXPECT_EQ(latin1Errors.at(0).column, 7);
+    EXPECT_EQ(latin1Errors.at(0).msg(), "Invalid UTF-8 byte, 0xE9, found.");
+    EXPECT_EQ(latin1Errors.at(1).offset, 17);
+    EXPECT_EQ(latin1Errors.at(2).arg, 0xFF);
+
+    // A byte right after a '*' in a comment is checked like any other - be it an invalid
+    // byte, a line break or another '*'.
+    const auto [starTokens, starErrors] = Scanner::scan("(* *\xE9 *\n **) x");
+    ASSERT_EQ(starErrors.size(), 1);
+    EXPECT_EQ(starErrors.at(0).code, ErrorCode::INVALID_ENCODING);
+    EXPECT_EQ(starErrors.at(0).offset, 4);
+    ASSERT_EQ(starTokens.size(), 2);
+    EXPECT_EQ(starTokens.at(0).lexeme, "x");
+    EXPECT_EQ(starTokens.at(0).line, 2);
+
+    // Sources embedded in the program are checked as well.
+    static_assert(Scanner::scanEmbedded<"(* Ol\xC3\xA1 *) MODULE M;">().errorCount == 0);
+    static_assert(Scanner::scanEmbedded<"(* Ol\xE1 *) MODULE M;">().errorCount == 1);
+}
+
+TEST(ScannerTests, TestEmbeddedScan) { // NOLINT(*-throwing-static-initialization, *-owning-memory, *-function-cognitive-complexity)
+    // A source scanned at compile time must have the same tokens as the ones found by a scan
+    // of the same source at runtime.
+    static constexpr EmbeddedSrc embeddedSrc{R"(
+MODULE Embedded;
+    CONST Star = 2AX; Max = 0FFH; Scale = 1.5E+3;
+    VAR s: ARRAY 8 OF CHAR;
+BEGIN
+    (* Comments are not tokens *)
+    s := "text";
+    IF Max >= 10 THEN s[0] := Star END
+END Embedded.
+)"};
+    static constexpr auto embedded = Scanner::scanEmbedded<embeddedSrc>();
+
+    static_assert(embedded.errorCount == 0);
+    static_assert(embedded.tokens.at(0).type == TokenType::MODULE);
+    static_assert(embedded.lexeme(embedded.tokens.at(1)) == "Embedded");
+    static_assert(embedded.tokens.at(6).type == TokenType::STRING);
+    static_assert(embedded.lexeme(embedded.tokens.at(6)) == "*");
+    static_assert(embedded.tokens.at(embedded.tokens.size() - 1).type == TokenType::EOM);
+
+    expectSameResults(ScanResults{.tokens = embedded.toTokens(), .errors = {}},
+                      Scanner::scan(std::string{embeddedSrc.view()}));
+
+    // Lexical errors are counted, so embedded sources can be verified at compile time.
+    static constexpr auto lowerEmbedded =
+          Scanner::scanEmbedded<"module Lower; var i: integer?; end Lower.", true>();
+    static_assert(lowerEmbedded.errorCount == 1);
+    static_assert(lowerEmbedded.tokens.at(0).type == TokenType::MODULE);
+    static_assert(lowerEmbedded.tokens.at(3).type == TokenType::VAR);
+}
+
+TEST(ScannerTests, TestScanAllocations) { // NOLINT(*-throwing-static-initialization, *-owning-memory, *-function-cognitive-complexity)
+    // Scanning a module must take a bounded number of heap allocations - most lexemes fit in
+    // the small string buffer of their tokens, so the allocations come mostly from the growth
+    // of the tokens list.
+    ASSERT_TRUE(globalAllocHooksActive());
+    const std::string src{readSample("Samples.Mod")};
+
+    const AllocPhase scanPhase;
+    const auto [tokens, errors] = Scanner::scan(src);
+    const AllocStats scanStats = scanPhase.stats();
+    if constexpr (EXACT_ALLOC_COUNTS) {
+        EXPECT_LE(scanStats.allocations, 16);
+        EXPECT_LE(scanStats.peakLiveBytes, tokens.capacity() * sizeof(Token) * 2);
+    }
+
+    // A session reuses its lists - a second scan of the same source doesn't allocate any.
+    ScanSession session;
+    session.scan(src);
+    const AllocPhase sessionPhase;
+    session.scan(src);
+    if constexpr (EXACT_ALLOC_COUNTS) {
+        EXPECT_EQ(sessionPhase.stats().allocations, 0);
+    }
+
+    // Memory resources count their own allocations.
+    CountingResource resource;
+    {
+        std::pmr::vector<Token> pmrTokens{tokens.begin(), tokens.end(), &resource};
+        if constexpr (EXACT_ALLOC_COUNTS) {
+            EXPECT_EQ(resource.stats().allocations, 1);
+            EXPECT_EQ(resource.stats().liveBytes, tokens.size() * sizeof(Token));
+        }
+        EXPECT_GE(resource.stats().liveBytes, tokens.size() * sizeof(Token));
+    }
+    EXPECT_EQ(resource.stats().deallocations, resource.stats().allocations);
+    EXPECT_EQ(resource.stats().liveBytes, 0);
+}
+
+TEST(ScannerTests, TestTrace) { // NOLINT(*-throwing-static-initialization, *-owning-memory, *-function-cognitive-complexity)
+    // Scans traced on different threads must be written as balanced begin and end events,
+    // attributed to their modules and threads.
+    const std::string src_file_path{samplePath("Samples.Mod")};
+    setTracingEnabled(true);
+    {
+        const TraceModule traceModule{"Samples"};
+        Scanner::scanSrcFile(src_file_path);
+    }
+    std::thread scanThread{[] {
+        const TraceModule traceModule{"Other \"quoted\""};
+        Scanner::scan("MODULE Other; END Other.");
+    }};
+    scanThread.join();
+    setTracingEnabled(false);
+    // Nothing is recorded while tracing is disabled.
+    Scanner::scan("MODULE Untraced; END Untraced.");
+    // Tracing again keeps both the events and the clock of the trace.
+    setTracingEnabled(true);
+    Scanner::scan("MODULE Again; END Again.");
+    setTracingEnabled(false);
+
+    std::ostringstream traceStream;
+    writeChromeTrace(traceStream);
+    const std::string trace{traceStream.str()};
+    const auto count = [&trace](const std::string_view str) {
+        std::size_t occurrences = 0;
+        for (auto pos = trace.find(str); pos != std::string::npos;
+             pos = trace.find(str, pos + 1)) {
+            occurrences++;
+        }
+        return occurrences;
+    };
+    EXPECT_EQ(trace.rfind(R"({"traceEvents":[)", 0), 0);
+    EXPECT_EQ(count(R"("ph":"B")"), 4);
+    EXPECT_EQ(count(R"("ph":"E")"), 4);
+    EXPECT_EQ(count(R"({"name":"load","cat":"obc","ph":"B")"), 1);
+    EXPECT_EQ(count(R"({"name":"scan","cat":"obc","ph":"B")"), 3);
+    EXPECT_EQ(count(R"("args":{"module":"Samples"})"), 2);
+    EXPECT_EQ(count(R"("args":{"module":"Other \"quoted\""})"), 1);
+    // The id is followed by the args of a begin event, or by the end of an end event - so
+    // matching the ids doesn't also match longer ones, such as 10.
+    EXPECT_EQ(count(R"("tid":1,)") + count(R"("tid":1})"), 6);
+    EXPECT_EQ(count(R"("tid":2,)") + count(R"("tid":2})"), 2);
+
+    // The events of a thread are written in the order they were recorded - and, as the clock
+    // wasn't restarted, so are their timestamps.
+    std::istringstream eventLines{trace};
+    double prevTimestamp = -1.0;
+    for (std::string line; std::getline(eventLines, line);) {
+        if (line.find(R"("tid":1,)") == std::string::npos &&
+            line.find(R"("tid":1})") == std::string::npos) {
+            continue;
+        }
+        const double timestamp = std::stod(line.substr(line.find(R"("ts":)") + 5));
+        EXPECT_GE(timestamp, prevTimestamp);
+        prevTimestamp = timestamp;
+    }
 }